@@ -40,12 +40,14 @@ class BFS : public ParallelAppBase<FRAG_T, BFSContext<FRAG_T>>,
   using vertex_t = typename fragment_t::vertex_t;
 
   static constexpr bool need_split_edges = true;
+  static constexpr bool speculative_termination = true;
 
   void PEval(const fragment_t& frag, context_t& ctx,
              message_manager_t& messages) {
     using depth_type = typename context_t::depth_type;
 
     messages.InitChannels(thread_num(), 2 * 1023 * 64, 2 * 1024 * 64);
+    messages.EnableCompression<fragment_t, EmptyType>();
 
     ctx.current_depth = 1;
 
@@ -113,7 +115,7 @@ class BFS : public ParallelAppBase<FRAG_T, BFSContext<FRAG_T>>,
         thrd_num, frag, [&ctx](int tid, vertex_t v, EmptyType) {
           if (ctx.partial_result[v] == std::numeric_limits<depth_type>::max()) {
             ctx.partial_result[v] = ctx.current_depth;
-            ctx.curr_inner_updated.Insert(v);
+            ctx.curr_inner_updated.Insert(v, tid);
           }
         });
 
@@ -153,7 +155,7 @@ class BFS : public ParallelAppBase<FRAG_T, BFSContext<FRAG_T>>,
               auto u = e.neighbor;
               if (ctx.curr_inner_updated.Exist(u)) {
                 ctx.partial_result[v] = next_depth;
-                ctx.next_inner_updated.Insert(v);
+                ctx.next_inner_updated.Insert(v, tid);
                 break;
               }
             }
@@ -171,7 +173,7 @@ class BFS : public ParallelAppBase<FRAG_T, BFSContext<FRAG_T>>,
               if (frag.IsOuterVertex(u)) {
                 channels[tid].SyncStateOnOuterVertex<fragment_t>(frag, u);
               } else {
-                ctx.next_inner_updated.Insert(u);
+                ctx.next_inner_updated.Insert(u, tid);
               }
             }
           }
@@ -188,7 +190,7 @@ class BFS : public ParallelAppBase<FRAG_T, BFSContext<FRAG_T>>,
             if (frag.IsOuterVertex(u)) {
               channels[tid].SyncStateOnOuterVertex<fragment_t>(frag, u);
             } else {
-              ctx.next_inner_updated.Insert(u);
+              ctx.next_inner_updated.Insert(u, tid);
             }
           }
         }
@@ -84,11 +84,8 @@ class BFSAuto : public AutoAppBase<FRAG_T, BFSAutoContext<FRAG_T>> {
 
     // filter changed vertices and enqueue, then run BFS until converged
     std::queue<vertex_t> que;
-    for (auto v : inner_vertices) {
-      if (ctx.partial_result.IsUpdated(v)) {
-        que.push(v);
-      }
-    }
+    ctx.partial_result.ForEachUpdated(inner_vertices,
+                                      [&que](vertex_t v) { que.push(v); });
 
     LocalBFS(frag, ctx, que);
   }
@@ -38,14 +38,7 @@ class BFSAutoContext : public ContextBase<FRAG_T> {
 
     auto vertices = frag.Vertices();
     partial_result.Init(vertices, std::numeric_limits<int64_t>::max(),
-                        [](int64_t& lhs, int64_t rhs) {
-                          if (lhs > rhs) {
-                            lhs = rhs;
-                            return true;
-                          } else {
-                            return false;
-                          }
-                        });
+                        AtomicMinAggregator<int64_t>());
 
     messages.RegisterSyncBuffer(frag, &partial_result,
                                 MessageStrategy::kSyncOnOuterVertex);
@@ -59,7 +52,8 @@ class BFSAutoContext : public ContextBase<FRAG_T> {
   }
 
   oid_t source_id;
-  SyncBuffer<int64_t, vid_t> partial_result;
+  ConcurrentSyncBuffer<int64_t, vid_t, AtomicMinAggregator<int64_t>>
+      partial_result;
 };
 }  // namespace grape
 
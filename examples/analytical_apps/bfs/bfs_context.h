@@ -65,7 +65,7 @@ class BFSContext : public ContextBase<FRAG_T> {
 
   oid_t source_id;
   VertexArray<depth_type, vid_t> partial_result;
-  DenseVertexSet<vid_t> curr_inner_updated, next_inner_updated;
+  Frontier<vid_t> curr_inner_updated, next_inner_updated;
 
   depth_type current_depth = 0;
   double avg_degree = 0;
@@ -77,11 +77,11 @@ class CDLP : public ParallelAppBase<FRAG_T, CDLPContext<FRAG_T>>,
     ctx.postprocess_time -= GetCurrentTime();
 #endif
 
-    for (auto v : inner_vertices) {
+    ForEach(inner_vertices, [&ctx, &new_ilabels](int tid, vertex_t v) {
       if (ctx.changed[v]) {
         ctx.labels[v] = new_ilabels[v];
       }
-    }
+    });
 
 #ifdef PROFILING
     ctx.postprocess_time += GetCurrentTime();
@@ -92,6 +92,7 @@ class CDLP : public ParallelAppBase<FRAG_T, CDLPContext<FRAG_T>>,
   static constexpr MessageStrategy message_strategy =
       MessageStrategy::kAlongOutgoingEdgeToOuterVertex;
   static constexpr LoadStrategy load_strategy = LoadStrategy::kOnlyOut;
+  static constexpr bool speculative_termination = true;
   using vertex_t = typename fragment_t::vertex_t;
 
   void PEval(const fragment_t& frag, context_t& ctx,
@@ -43,3 +43,25 @@ DEFINE_string(serialization_prefix, "",
               "where to load/store the serialization files");
 
 DEFINE_int32(app_concurrency, -1, "concurrency of application");
+DEFINE_bool(numa, false,
+            "whether to bind threads to NUMA nodes and schedule vertices "
+            "node-locally.");
+DEFINE_bool(affinity, false,
+            "whether to bind threads to cpus, hyperthread siblings are used "
+            "only after all the physical cores are taken.");
+DEFINE_int32(comm_cores, 0,
+             "number of cores per process reserved for communication threads, "
+             "only works without app_concurrency.");
+DEFINE_int32(async_staleness, 0,
+             "staleness bound of fragments for async apps, 0 for unbounded.");
+DEFINE_string(sync_codec, "none",
+              "lossy codec of synchronizing mirrors for batch shuffle apps, "
+              "one of none, float, bf16 and fixed.");
+DEFINE_double(sync_max_error, 0,
+              "bound of the absolute error of sync_codec, 0 for unbounded.");
+DEFINE_bool(shm_transport, false,
+            "exchange messages with workers on the same host through shared "
+            "memory, except for async apps.");
+DEFINE_bool(hierarchical_routing, false,
+            "route messages to other hosts through host leaders, for auto "
+            "apps.");
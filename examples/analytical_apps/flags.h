@@ -40,5 +40,13 @@ DECLARE_bool(deserialize);
 DECLARE_string(serialization_prefix);
 
 DECLARE_int32(app_concurrency);
+DECLARE_bool(numa);
+DECLARE_bool(affinity);
+DECLARE_int32(comm_cores);
+DECLARE_int32(async_staleness);
+DECLARE_string(sync_codec);
+DECLARE_double(sync_max_error);
+DECLARE_bool(shm_transport);
+DECLARE_bool(hierarchical_routing);
 
 #endif  // EXAMPLES_ANALYTICAL_APPS_FLAGS_H_
@@ -93,31 +93,33 @@ class LCC : public ParallelAppBase<FRAG_T, LCCContext<FRAG_T>>,
       ctx.exec_time -= GetCurrentTime();
 #endif
 
-      ForEach(inner_vertices, [&frag, &ctx, &messages](int tid, vertex_t v) {
-        vid_t u_gid, v_gid;
-        auto& nbr_vec = ctx.complete_neighbor[v];
-        int degree = ctx.global_degree[v];
-        nbr_vec.reserve(degree);
-        auto es = frag.GetOutgoingAdjList(v);
-        std::vector<vid_t> msg_vec;
-        msg_vec.reserve(degree);
-        for (auto& e : es) {
-          auto u = e.neighbor;
-          if (ctx.global_degree[u] < ctx.global_degree[v]) {
-            nbr_vec.push_back(u);
-            msg_vec.push_back(frag.Vertex2Gid(u));
-          } else if (ctx.global_degree[u] == ctx.global_degree[v]) {
-            u_gid = frag.Vertex2Gid(u);
-            v_gid = frag.GetInnerVertexGid(v);
-            if (v_gid > u_gid) {
-              nbr_vec.push_back(u);
-              msg_vec.push_back(u_gid);
+      ForEachEdgeBalanced(
+          inner_vertices, frag.GetOutgoingOffsets(),
+          [&frag, &ctx, &messages](int tid, vertex_t v) {
+            vid_t u_gid, v_gid;
+            auto& nbr_vec = ctx.complete_neighbor[v];
+            int degree = ctx.global_degree[v];
+            nbr_vec.reserve(degree);
+            auto es = frag.GetOutgoingAdjList(v);
+            std::vector<vid_t> msg_vec;
+            msg_vec.reserve(degree);
+            for (auto& e : es) {
+              auto u = e.neighbor;
+              if (ctx.global_degree[u] < ctx.global_degree[v]) {
+                nbr_vec.push_back(u);
+                msg_vec.push_back(frag.Vertex2Gid(u));
+              } else if (ctx.global_degree[u] == ctx.global_degree[v]) {
+                u_gid = frag.Vertex2Gid(u);
+                v_gid = frag.GetInnerVertexGid(v);
+                if (v_gid > u_gid) {
+                  nbr_vec.push_back(u);
+                  msg_vec.push_back(u_gid);
+                }
+              }
             }
-          }
-        }
-        messages.SendMsgThroughOEdges<fragment_t, std::vector<vid_t>>(
-            frag, v, msg_vec, tid);
-      });
+            messages.SendMsgThroughOEdges<fragment_t, std::vector<vid_t>>(
+                frag, v, msg_vec, tid);
+          });
 
 #ifdef PROFILING
       ctx.exec_time += GetCurrentTime();
@@ -149,8 +151,8 @@ class LCC : public ParallelAppBase<FRAG_T, LCCContext<FRAG_T>>,
 
       std::vector<DenseVertexSet<vid_t>> vertexsets(thread_num());
 
-      ForEach(
-          inner_vertices,
+      ForEachEdgeBalanced(
+          inner_vertices, frag.GetOutgoingOffsets(),
           [&vertexsets, &frag](int tid) {
             auto& ns = vertexsets[tid];
             ns.Init(frag.Vertices());
@@ -161,15 +163,25 @@ class LCC : public ParallelAppBase<FRAG_T, LCCContext<FRAG_T>>,
             for (auto u : v0_nbr_vec) {
               v0_nbr_set.Insert(u);
             }
+            // count triangles of v and u locally, and add them to the
+            // shared counters once.
+            int v_cnt = 0;
             for (auto u : v0_nbr_vec) {
               auto& v1_nbr_vec = ctx.complete_neighbor[u];
+              int u_cnt = 0;
               for (auto w : v1_nbr_vec) {
                 if (v0_nbr_set.Exist(w)) {
-                  atomic_add(ctx.tricnt[u], 1);
-                  atomic_add(ctx.tricnt[v], 1);
+                  ++u_cnt;
                   atomic_add(ctx.tricnt[w], 1);
                 }
               }
+              if (u_cnt != 0) {
+                atomic_add(ctx.tricnt[u], u_cnt);
+                v_cnt += u_cnt;
+              }
+            }
+            if (v_cnt != 0) {
+              atomic_add(ctx.tricnt[v], v_cnt);
             }
             for (auto u : v0_nbr_vec) {
               v0_nbr_set.Erase(u);
@@ -199,9 +211,9 @@ class LCC : public ParallelAppBase<FRAG_T, LCCContext<FRAG_T>>,
 #ifdef PROFILING
       ctx.preprocess_time -= GetCurrentTime();
 #endif
-      messages.ParallelProcess<fragment_t, int>(
+      messages.ParallelProcessByOwner<fragment_t, int>(
           thread_num(), frag, [&ctx](int tid, vertex_t u, int deg) {
-            atomic_add(ctx.tricnt[u], deg);
+            ctx.tricnt[u] += deg;
           });
 #ifdef PROFILING
       ctx.preprocess_time += GetCurrentTime();
@@ -88,6 +88,9 @@ class PageRank
     ctx.postprocess_time -= GetCurrentTime();
 #endif
 
+    // ranks of many vertices converge in late rounds, ship only changed ones
+    // when it pays off.
+    messages.EnableDeltaSync();
     messages.SyncInnerVertices<fragment_t, double>(frag, ctx.result,
                                                    thread_num());
 #ifdef PROFILING
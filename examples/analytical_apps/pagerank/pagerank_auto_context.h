@@ -39,10 +39,7 @@ class PageRankAutoContext : public ContextBase<FRAG_T> {
     auto inner_vertices = frag.InnerVertices();
     auto vertices = frag.Vertices();
     degree.Init(inner_vertices, 0);
-    results.Init(vertices, 0.0, [](double& lhs, double rhs) {
-      lhs = rhs;
-      return true;
-    });
+    results.Init(vertices, 0.0, OverwriteAggregator<double>());
 
     messages.RegisterSyncBuffer(
         frag, &results, MessageStrategy::kAlongOutgoingEdgeToOuterVertex);
@@ -63,7 +60,7 @@ class PageRankAutoContext : public ContextBase<FRAG_T> {
   }
 
   VertexArray<int, vid_t> degree;
-  SyncBuffer<double, vid_t> results;
+  SyncBuffer<double, vid_t, OverwriteAggregator<double>> results;
   int step = 0;
   int max_round = 0;
   double delta = 0;
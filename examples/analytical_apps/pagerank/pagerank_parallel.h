@@ -40,6 +40,8 @@ class PageRankParallel
       public ParallelEngine {
  public:
   using vertex_t = typename FRAG_T::vertex_t;
+  using vid_t = typename FRAG_T::vid_t;
+  using nbr_t = typename FRAG_T::nbr_t;
   static constexpr MessageStrategy message_strategy =
       MessageStrategy::kAlongOutgoingEdgeToOuterVertex;
   static constexpr bool need_split_edges = true;
@@ -53,8 +55,14 @@ class PageRankParallel
              message_manager_t& messages) {
     auto inner_vertices = frag.InnerVertices();
 
+    // place the vertex states on the NUMA nodes processing them, which takes
+    // effect only if the engine runs in NUMA mode.
+    LocalizeVertexArray(ctx.degree);
+    LocalizeVertexArray(ctx.result);
+    LocalizeVertexArray(ctx.next_result);
+
     size_t graph_vnum = frag.GetTotalVerticesNum();
-    messages.InitChannels(thread_num());
+    messages.InitTypedChannels<fragment_t, double>(thread_num());
 
 #ifdef PROFILING
     ctx.exec_time -= GetCurrentTime();
@@ -69,8 +77,8 @@ class PageRankParallel
       ctx.degree[u] = EdgeNum;
       if (EdgeNum > 0) {
         ctx.result[u] = p / EdgeNum;
-        messages.SendMsgThroughOEdges<fragment_t, double>(frag, u,
-                                                          ctx.result[u], tid);
+        messages.TypedChannel<fragment_t, double>(tid).SendMsgThroughOEdges(
+            frag, u, ctx.result[u]);
       } else {
         ctx.result[u] = p;
       }
@@ -81,11 +89,12 @@ class PageRankParallel
     ctx.postprocess_time -= GetCurrentTime();
 #endif
 
-    for (auto u : inner_vertices) {
-      if (ctx.degree[u] == 0) {
-        ++ctx.dangling_vnum;
-      }
-    }
+    ctx.dangling_vnum = ParallelReduce(
+        inner_vertices, static_cast<vid_t>(0),
+        [&ctx](int tid, vertex_t u) -> vid_t {
+          return ctx.degree[u] == 0 ? 1 : 0;
+        },
+        SumCombiner());
 
     double dangling_sum = p * static_cast<double>(ctx.dangling_vnum);
 
@@ -118,18 +127,13 @@ class PageRankParallel
         (1.0 - ctx.delta) / graph_vnum + ctx.delta * dangling_sum / graph_vnum;
 
     // pull ranks from neighbors
-    ForEach(inner_vertices, [&ctx, base, &frag](int tid, vertex_t u) {
-      if (ctx.degree[u] == 0) {
-        ctx.next_result[u] = base;
-      } else {
-        double cur = 0;
-        auto es = frag.GetIncomingInnerVertexAdjList(u);
-        for (auto& e : es) {
-          cur += ctx.result[e.neighbor];
-        }
-        ctx.next_result[u] = cur;
-      }
-    });
+    ForEachEdge(
+        inner_vertices, frag.GetIncomingOffsets(),
+        [&frag](vertex_t u) { return frag.GetIncomingInnerVertexAdjList(u); },
+        0.0, [&ctx](const nbr_t& e) { return ctx.result[e.neighbor]; },
+        SumCombiner(), [&ctx, base](int tid, vertex_t u, double cur) {
+          ctx.next_result[u] = (ctx.degree[u] == 0) ? base : cur;
+        });
 
 #ifdef PROFILING
     ctx.exec_time += GetCurrentTime();
@@ -138,9 +142,14 @@ class PageRankParallel
 
     // process received ranks sent by other workers
     {
-      messages.ParallelProcess<fragment_t, double>(
-          thread_num(), frag, [&ctx](int tid, vertex_t u, const double& msg) {
-            ctx.result[u] = msg;
+      messages.ParallelProcessSpans<fragment_t, double>(
+          thread_num(), [&ctx, &frag](int tid, const vid_t* gids,
+                                      const double* msgs, size_t num) {
+            vertex_t u;
+            for (size_t i = 0; i < num; ++i) {
+              frag.Gid2Vertex(gids[i], u);
+              ctx.result[u] = msgs[i];
+            }
           });
     }
 
@@ -151,32 +160,35 @@ class PageRankParallel
 
     // compute new ranks and send messages
     if (ctx.step != ctx.max_round) {
-      ForEach(inner_vertices,
-              [&ctx, base, &frag, &messages](int tid, vertex_t u) {
-                if (ctx.degree[u] != 0) {
-                  double cur = ctx.next_result[u];
-                  auto es = frag.GetIncomingOuterVertexAdjList(u);
-                  for (auto& e : es) {
-                    cur += ctx.result[e.neighbor];
-                  }
-                  cur = (ctx.delta * cur + base) / ctx.degree[u];
-                  ctx.next_result[u] = cur;
-                  messages.SendMsgThroughOEdges<fragment_t, double>(
-                      frag, u, ctx.next_result[u], tid);
-                }
-              });
+      ForEachEdgeBalanced(
+          inner_vertices, frag.GetIncomingOffsets(),
+          [&ctx, base, &frag, &messages](int tid, vertex_t u) {
+            if (ctx.degree[u] != 0) {
+              double cur = ctx.next_result[u];
+              auto es = frag.GetIncomingOuterVertexAdjList(u);
+              for (auto& e : es) {
+                cur += ctx.result[e.neighbor];
+              }
+              cur = (ctx.delta * cur + base) / ctx.degree[u];
+              ctx.next_result[u] = cur;
+              messages.TypedChannel<fragment_t, double>(tid)
+                  .SendMsgThroughOEdges(frag, u, ctx.next_result[u]);
+            }
+          });
     } else {
-      ForEach(inner_vertices, [&ctx, base, &frag](int tid, vertex_t u) {
-        if (ctx.degree[u] != 0) {
-          double cur = ctx.next_result[u];
-          auto es = frag.GetIncomingOuterVertexAdjList(u);
-          for (auto& e : es) {
-            cur += ctx.result[e.neighbor];
-          }
-          cur = (ctx.delta * cur + base) / ctx.degree[u];
-          ctx.next_result[u] = cur;
-        }
-      });
+      ForEachEdgeBalanced(
+          inner_vertices, frag.GetIncomingOffsets(),
+          [&ctx, base, &frag](int tid, vertex_t u) {
+            if (ctx.degree[u] != 0) {
+              double cur = ctx.next_result[u];
+              auto es = frag.GetIncomingOuterVertexAdjList(u);
+              for (auto& e : es) {
+                cur += ctx.result[e.neighbor];
+              }
+              cur = (ctx.delta * cur + base) / ctx.degree[u];
+              ctx.next_result[u] = cur;
+            }
+          });
     }
 
 #ifdef PROFILING
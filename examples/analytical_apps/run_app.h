@@ -51,9 +51,11 @@ limitations under the License.
 #include "pagerank/pagerank_local_parallel.h"
 #include "pagerank/pagerank_parallel.h"
 #include "sssp/sssp.h"
+#include "sssp/sssp_async.h"
 #include "sssp/sssp_auto.h"
 #include "timer.h"
 #include "wcc/wcc.h"
+#include "wcc/wcc_async.h"
 #include "wcc/wcc_auto.h"
 
 namespace grape {
@@ -85,6 +87,46 @@ void Finalize() {
   VLOG(1) << "Workers finalized.";
 }
 
+template <typename WORKER_T>
+void SetWorkerOptions(WORKER_T& worker) {
+  if (FLAGS_shm_transport) {
+    worker.EnableShmTransport();
+  }
+}
+
+template <typename APP_T>
+void SetWorkerOptions(AutoWorker<APP_T>& worker) {
+  if (FLAGS_shm_transport) {
+    worker.EnableShmTransport();
+  }
+  if (FLAGS_hierarchical_routing) {
+    worker.EnableHierarchicalRouting();
+  }
+}
+
+template <typename APP_T>
+void SetWorkerOptions(AsyncWorker<APP_T>& worker) {
+  worker.SetStaleness(FLAGS_async_staleness);
+}
+
+template <typename APP_T>
+void SetWorkerOptions(BatchShuffleWorker<APP_T>& worker) {
+  LossyCodecType codec = LossyCodecType::kNone;
+  if (FLAGS_sync_codec == "float") {
+    codec = LossyCodecType::kFloat;
+  } else if (FLAGS_sync_codec == "bf16") {
+    codec = LossyCodecType::kBFloat16;
+  } else if (FLAGS_sync_codec == "fixed") {
+    codec = LossyCodecType::kFixedPoint;
+  } else if (FLAGS_sync_codec != "none") {
+    LOG(FATAL) << "Invalid sync_codec: " << FLAGS_sync_codec;
+  }
+  worker.SetLossyCodec(codec, FLAGS_sync_max_error);
+  if (FLAGS_shm_transport) {
+    worker.EnableShmTransport();
+  }
+}
+
 template <typename FRAG_T, typename APP_T, typename... Args>
 void CreateAndQuery(const CommSpec& comm_spec, const std::string efile,
                     const std::string& vfile, const std::string& out_prefix,
@@ -98,6 +140,7 @@ void CreateAndQuery(const CommSpec& comm_spec, const std::string efile,
   } else if (FLAGS_serialize) {
     graph_spec.set_serialize(true, FLAGS_serialization_prefix);
   }
+  graph_spec.set_comm_cpu_list(spec.comm_cpu_list);
   std::shared_ptr<FRAG_T> fragment;
   if (FLAGS_segmented_partition) {
     fragment = LoadGraph<FRAG_T, SegmentedPartitioner<typename FRAG_T::oid_t>>(
@@ -110,6 +153,7 @@ void CreateAndQuery(const CommSpec& comm_spec, const std::string efile,
   timer_next("load application");
   auto worker = APP_T::CreateWorker(app, fragment);
   worker->Init(comm_spec, spec);
+  SetWorkerOptions(*worker);
   timer_next("run algorithm");
   worker->Query(std::forward<Args>(args)...);
   timer_next("print output");
@@ -158,11 +202,11 @@ void Run() {
   std::string efile = FLAGS_efile;
   std::string vfile = FLAGS_vfile;
   std::string out_prefix = FLAGS_out_prefix;
-  auto spec = DefaultParallelEngineSpec();
+  auto spec = MultiProcessSpec(comm_spec, FLAGS_affinity, FLAGS_numa,
+                               FLAGS_comm_cores);
   if (FLAGS_app_concurrency != -1) {
+    // threads are still bound to the cpus of this process on the host.
     spec.thread_num = FLAGS_app_concurrency;
-  } else {
-    spec = MultiProcessSpec(comm_spec, false);
   }
   int fnum = comm_spec.fnum();
   std::string name = FLAGS_application;
@@ -176,6 +220,10 @@ void Run() {
       using AppType = SSSP<GraphType>;
       CreateAndQuery<GraphType, AppType, OID_T>(
           comm_spec, efile, vfile, out_prefix, fnum, spec, FLAGS_sssp_source);
+    } else if (name == "sssp_async") {
+      using AppType = SSSPAsync<GraphType>;
+      CreateAndQuery<GraphType, AppType, OID_T>(
+          comm_spec, efile, vfile, out_prefix, fnum, spec, FLAGS_sssp_source);
     } else {
       LOG(FATAL) << "No avaiable application named [" << name << "].";
     }
@@ -251,6 +299,12 @@ void Run() {
       using AppType = WCC<GraphType>;
       CreateAndQuery<GraphType, AppType>(comm_spec, efile, vfile, out_prefix,
                                          fnum, spec);
+    } else if (name == "wcc_async") {
+      using GraphType = ImmutableEdgecutFragment<OID_T, VID_T, VDATA_T, EDATA_T,
+                                                 LoadStrategy::kOnlyOut>;
+      using AppType = WCCAsync<GraphType>;
+      CreateAndQuery<GraphType, AppType>(comm_spec, efile, vfile, out_prefix,
+                                         fnum, spec);
     } else if (name == "lcc_auto") {
       using GraphType = ImmutableEdgecutFragment<OID_T, VID_T, VDATA_T, EDATA_T,
                                                  LoadStrategy::kOnlyOut>;
@@ -40,7 +40,40 @@ class SSSP : public ParallelAppBase<FRAG_T, SSSPContext<FRAG_T>>,
   // specialize the templated worker.
   INSTALL_PARALLEL_WORKER(SSSP<FRAG_T>, SSSPContext<FRAG_T>, FRAG_T)
   using vertex_t = typename fragment_t::vertex_t;
+  using vid_t = typename fragment_t::vid_t;
 
+  static constexpr bool speculative_termination = true;
+
+ private:
+  // incremental evaluation on the frontier, distances of outer vertices are
+  // put into channels corresponding to the destination fragments, and
+  // combined in each channel by min.
+  void Relax(const fragment_t& frag, context_t& ctx,
+             message_manager_t& messages, Frontier<vid_t>& frontier) {
+    auto inner_vertices = frag.InnerVertices();
+    auto& channels = messages.Channels();
+
+    ForEach(frontier, inner_vertices,
+            [&channels, &frag, &ctx](int tid, vertex_t v) {
+              double distv = ctx.partial_result[v];
+              auto es = frag.GetOutgoingAdjList(v);
+              for (auto& e : es) {
+                vertex_t u = e.neighbor;
+                double ndistu = distv + e.data;
+                if (ndistu < ctx.partial_result[u]) {
+                  atomic_min(ctx.partial_result[u], ndistu);
+                  if (frag.IsOuterVertex(u)) {
+                    channels[tid].SyncStateOnOuterVertex<fragment_t, double>(
+                        frag, u, ndistu, MinCombiner());
+                  } else {
+                    ctx.next_modified.Insert(u, tid);
+                  }
+                }
+              }
+            });
+  }
+
+ public:
   /**
    * @brief Partial evaluation for SSSP.
    *
@@ -60,7 +93,9 @@ class SSSP : public ParallelAppBase<FRAG_T, SSSPContext<FRAG_T>>,
     ctx.exec_time -= GetCurrentTime();
 #endif
 
-    ctx.next_modified.parallel_clear(thread_num());
+    ctx.curr_modified.Init(frag.Vertices(), thread_num());
+    ctx.next_modified.Init(frag.Vertices(), thread_num());
+    ctx.recv_modified.Init(frag.Vertices());
 
     // Get the channel. Messages assigned to this channel will be sent by the
     // message manager in parallel with the evaluation process.
@@ -77,7 +112,7 @@ class SSSP : public ParallelAppBase<FRAG_T, SSSPContext<FRAG_T>>,
           channel_0.SyncStateOnOuterVertex<fragment_t, double>(
               frag, v, ctx.partial_result[v]);
         } else {
-          ctx.next_modified.set_bit(v.GetValue());
+          ctx.next_modified.Insert(v);
         }
       }
     }
@@ -89,7 +124,7 @@ class SSSP : public ParallelAppBase<FRAG_T, SSSPContext<FRAG_T>>,
 
     messages.ForceContinue();
 
-    ctx.next_modified.swap(ctx.curr_modified);
+    ctx.next_modified.Swap(ctx.curr_modified);
 #ifdef PROFILING
     ctx.postprocess_time += GetCurrentTime();
 #endif
@@ -104,22 +139,20 @@ class SSSP : public ParallelAppBase<FRAG_T, SSSPContext<FRAG_T>>,
    */
   void IncEval(const fragment_t& frag, context_t& ctx,
                message_manager_t& messages) {
-    auto inner_vertices = frag.InnerVertices();
-
-    auto& channels = messages.Channels();
-
 #ifdef PROFILING
     ctx.preprocess_time -= GetCurrentTime();
 #endif
 
-    ctx.next_modified.parallel_clear(thread_num());
+    ctx.next_modified.ParallelClear(thread_num());
+    ctx.recv_modified.Clear();
 
-    // parallel process and reduce the received messages
-    messages.ParallelProcess<fragment_t, double>(
-        thread_num(), frag, [&ctx](int tid, vertex_t u, double msg) {
+    // process the received messages in background, vertices updated by
+    // messages are collected into recv_modified.
+    messages.StartParallelProcess<fragment_t, double>(
+        1, frag, [&ctx](int tid, vertex_t u, double msg) {
           if (ctx.partial_result[u] > msg) {
             atomic_min(ctx.partial_result[u], msg);
-            ctx.curr_modified.set_bit(u.GetValue());
+            ctx.recv_modified.Insert(u, tid);
           }
         });
 
@@ -128,39 +161,22 @@ class SSSP : public ParallelAppBase<FRAG_T, SSSPContext<FRAG_T>>,
     ctx.exec_time -= GetCurrentTime();
 #endif
 
-    // incremental evaluation.
-    ForEach(ctx.curr_modified, inner_vertices,
-            [&frag, &ctx](int tid, vertex_t v) {
-              double distv = ctx.partial_result[v];
-              auto es = frag.GetOutgoingAdjList(v);
-              for (auto& e : es) {
-                vertex_t u = e.neighbor;
-                double ndistu = distv + e.data;
-                if (ndistu < ctx.partial_result[u]) {
-                  atomic_min(ctx.partial_result[u], ndistu);
-                  ctx.next_modified.set_bit(u.GetValue());
-                }
-              }
-            });
-
-    // put messages into channels corresponding to the destination fragments.
+    // relax the vertices modified locally in the last round while messages
+    // are being received, then those updated by messages.
+    Relax(frag, ctx, messages, ctx.curr_modified);
+    messages.WaitParallelProcess();
+    Relax(frag, ctx, messages, ctx.recv_modified);
 
 #ifdef PROFILING
     ctx.exec_time += GetCurrentTime();
     ctx.postprocess_time -= GetCurrentTime();
 #endif
-    auto outer_vertices = frag.OuterVertices();
-    ForEach(ctx.next_modified, outer_vertices,
-            [&channels, &frag, &ctx](int tid, vertex_t v) {
-              channels[tid].SyncStateOnOuterVertex<fragment_t, double>(
-                  frag, v, ctx.partial_result[v]);
-            });
 
-    if (!ctx.next_modified.partial_empty(0, frag.GetInnerVerticesNum())) {
+    if (!ctx.next_modified.PartialEmpty(0, frag.GetInnerVerticesNum())) {
       messages.ForceContinue();
     }
 
-    ctx.next_modified.swap(ctx.curr_modified);
+    ctx.next_modified.Swap(ctx.curr_modified);
 #ifdef PROFILING
     ctx.postprocess_time += GetCurrentTime();
 #endif
@@ -0,0 +1,41 @@
+/** Copyright 2020 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef EXAMPLES_ANALYTICAL_APPS_SSSP_SSSP_ASYNC_H_
+#define EXAMPLES_ANALYTICAL_APPS_SSSP_SSSP_ASYNC_H_
+
+#include <grape/grape.h>
+
+#include "sssp/sssp.h"
+#include "sssp/sssp_context.h"
+
+namespace grape {
+
+/**
+ * @brief SSSP application running asynchronously with AsyncWorker. Each
+ * fragment relaxes distances whenever it receives messages, without waiting
+ * for other fragments, since the result doesn't depend on the order in which
+ * distances are received.
+ *
+ * @tparam FRAG_T
+ */
+template <typename FRAG_T>
+class SSSPAsync : public SSSP<FRAG_T> {
+  INSTALL_ASYNC_PARALLEL_WORKER(SSSPAsync<FRAG_T>, SSSPContext<FRAG_T>, FRAG_T)
+};
+
+}  // namespace grape
+
+#endif  // EXAMPLES_ANALYTICAL_APPS_SSSP_SSSP_ASYNC_H_
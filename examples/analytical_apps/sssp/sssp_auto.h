@@ -118,11 +118,9 @@ class SSSPAuto : public AutoAppBase<FRAG_T, SSSPAutoContext<FRAG_T>> {
 
     std::priority_queue<std::pair<double, vertex_t>> heap;
 
-    for (auto& v : inner_vertices) {
-      if (ctx.partial_result.IsUpdated(v)) {
-        heap.emplace(-ctx.partial_result.GetValue(v), v);
-      }
-    }
+    ctx.partial_result.ForEachUpdated(inner_vertices, [&](vertex_t v) {
+      heap.emplace(-ctx.partial_result.GetValue(v), v);
+    });
 
     Dijkstra(frag, ctx, heap);
   }
@@ -39,14 +39,7 @@ class SSSPAutoContext : public ContextBase<FRAG_T> {
     this->source_id = source_id;
     auto vertices = frag.Vertices();
     partial_result.Init(vertices, std::numeric_limits<double>::max(),
-                        [](double& lhs, double rhs) {
-                          if (lhs > rhs) {
-                            lhs = rhs;
-                            return true;
-                          } else {
-                            return false;
-                          }
-                        });
+                        AtomicMinAggregator<double>());
     messages.RegisterSyncBuffer(frag, &partial_result,
                                 MessageStrategy::kSyncOnOuterVertex);
   }
@@ -68,7 +61,8 @@ class SSSPAutoContext : public ContextBase<FRAG_T> {
   }
 
   oid_t source_id;
-  SyncBuffer<double, vid_t> partial_result;
+  ConcurrentSyncBuffer<double, vid_t, AtomicMinAggregator<double>>
+      partial_result;
 };
 }  // namespace grape
 
@@ -41,9 +41,6 @@ class SSSPContext : public ContextBase<FRAG_T> {
     auto vertices = frag.Vertices();
     partial_result.Init(vertices, std::numeric_limits<double>::max());
 
-    curr_modified.init(frag.GetVerticesNum());
-    next_modified.init(frag.GetVerticesNum());
-
 #ifdef PROFILING
     preprocess_time = 0;
     exec_time = 0;
@@ -75,7 +72,9 @@ class SSSPContext : public ContextBase<FRAG_T> {
   oid_t source_id;
   VertexArray<double, vid_t> partial_result;
 
-  Bitset curr_modified, next_modified;
+  Frontier<vid_t> curr_modified, next_modified;
+  // vertices updated by messages in a round.
+  Frontier<vid_t> recv_modified;
 
 #ifdef PROFILING
   double preprocess_time = 0;
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef EXAMPLES_ANALYTICAL_APPS_WCC_WCC_H_
 #define EXAMPLES_ANALYTICAL_APPS_WCC_WCC_H_
 
+#include <limits>
+
 #include <grape/grape.h>
 
 #include "wcc/wcc_context.h"
@@ -40,8 +42,10 @@ class WCC : public ParallelAppBase<FRAG_T, WCCContext<FRAG_T>>,
   INSTALL_PARALLEL_WORKER(WCC<FRAG_T>, WCCContext<FRAG_T>, FRAG_T)
   using vertex_t = typename fragment_t::vertex_t;
   using vid_t = typename fragment_t::vid_t;
+  using nbr_t = typename fragment_t::nbr_t;
 
   static constexpr bool need_split_edges = true;
+  static constexpr bool speculative_termination = true;
 
  private:
   // Propagate label through pulling.
@@ -53,64 +57,60 @@ class WCC : public ParallelAppBase<FRAG_T, WCCContext<FRAG_T>>,
 
     auto& channels = messages.Channels();
 
-    ForEach(inner_vertices, [&frag, &ctx](int tid, vertex_t v) {
-      auto old_cid = ctx.comp_id[v];
-      auto new_cid = old_cid;
-      auto es = frag.GetOutgoingInnerVertexAdjList(v);
-      for (auto& e : es) {
-        auto u = e.neighbor;
-        new_cid = MIN(ctx.comp_id[u], new_cid);
-      }
-      if (new_cid < old_cid) {
-        ctx.comp_id[v] = new_cid;
-        ctx.next_modified.set_bit(v.GetValue());
-      }
-    });
+    ForEachEdge(
+        inner_vertices,
+        [&frag](vertex_t v) { return frag.GetOutgoingInnerVertexAdjList(v); },
+        std::numeric_limits<vid_t>::max(),
+        [&ctx](const nbr_t& e) { return ctx.comp_id[e.neighbor]; },
+        MinCombiner(), [&ctx](int tid, vertex_t v, vid_t new_cid) {
+          if (new_cid < ctx.comp_id[v]) {
+            ctx.comp_id[v] = new_cid;
+            ctx.next_modified.Insert(v, tid);
+          }
+        });
 
-    ForEach(outer_vertices, [&frag, &ctx, &channels](int tid, vertex_t v) {
-      auto old_cid = ctx.comp_id[v];
-      auto new_cid = old_cid;
-      auto es = frag.GetIncomingAdjList(v);
-      for (auto& e : es) {
-        auto u = e.neighbor;
-        new_cid = MIN(ctx.comp_id[u], new_cid);
-      }
-      ctx.comp_id[v] = new_cid;
-      if (new_cid < old_cid) {
-        ctx.next_modified.set_bit(v.GetValue());
-        channels[tid].SyncStateOnOuterVertex<fragment_t, vid_t>(frag, v,
-                                                                new_cid);
-      }
-    });
+    ForEachEdge(
+        outer_vertices,
+        [&frag](vertex_t v) { return frag.GetIncomingAdjList(v); },
+        std::numeric_limits<vid_t>::max(),
+        [&ctx](const nbr_t& e) { return ctx.comp_id[e.neighbor]; },
+        MinCombiner(),
+        [&frag, &ctx, &channels](int tid, vertex_t v, vid_t new_cid) {
+          if (new_cid < ctx.comp_id[v]) {
+            ctx.comp_id[v] = new_cid;
+            ctx.next_modified.Insert(v, tid);
+            channels[tid].SyncStateOnOuterVertex<fragment_t, vid_t>(frag, v,
+                                                                    new_cid);
+          }
+        });
   }
 
   // Propagate label through pushing
   // Each vertex pushes its state to update neighbors.
   void PropagateLabelPush(const fragment_t& frag, context_t& ctx,
-                          message_manager_t& messages) {
+                          message_manager_t& messages,
+                          Frontier<vid_t>& frontier) {
     auto inner_vertices = frag.InnerVertices();
-    auto outer_vertices = frag.OuterVertices();
 
-    // propagate label to incoming and outgoing neighbors
-    ForEach(ctx.curr_modified, inner_vertices,
-            [&frag, &ctx](int tid, vertex_t v) {
+    // propagate label to incoming and outgoing neighbors, labels of outer
+    // vertices are combined by min in the channels before being sent.
+    ForEach(frontier, inner_vertices,
+            [&messages, &frag, &ctx](int tid, vertex_t v) {
               auto cid = ctx.comp_id[v];
               auto es = frag.GetOutgoingAdjList(v);
               for (auto& e : es) {
                 auto u = e.neighbor;
                 if (ctx.comp_id[u] > cid) {
                   atomic_min(ctx.comp_id[u], cid);
-                  ctx.next_modified.set_bit(u.GetValue());
+                  if (frag.IsOuterVertex(u)) {
+                    messages.SyncStateOnOuterVertex<fragment_t, vid_t>(
+                        frag, u, cid, tid, MinCombiner());
+                  } else {
+                    ctx.next_modified.Insert(u, tid);
+                  }
                 }
               }
             });
-
-    ForEach(outer_vertices, [&messages, &frag, &ctx](int tid, vertex_t v) {
-      if (ctx.next_modified.get_bit(v.GetValue())) {
-        messages.SyncStateOnOuterVertex<fragment_t, vid_t>(frag, v,
-                                                           ctx.comp_id[v], tid);
-      }
-    });
   }
 
  public:
@@ -120,6 +120,10 @@ class WCC : public ParallelAppBase<FRAG_T, WCCContext<FRAG_T>>,
     auto outer_vertices = frag.OuterVertices();
 
     messages.InitChannels(thread_num());
+    messages.EnableCompression<fragment_t, vid_t>();
+    ctx.curr_modified.Init(frag.Vertices(), thread_num());
+    ctx.next_modified.Init(frag.Vertices(), thread_num());
+    ctx.recv_modified.Init(frag.Vertices());
 
 #ifdef PROFILING
     ctx.eval_time -= GetCurrentTime();
@@ -136,11 +140,11 @@ class WCC : public ParallelAppBase<FRAG_T, WCCContext<FRAG_T>>,
     // In the first round, all vertices are active, pulling is more efficient.
     PropagateLabelPull(frag, ctx, messages);
 
-    if (!ctx.next_modified.partial_empty(0, frag.GetInnerVerticesNum())) {
+    if (!ctx.next_modified.PartialEmpty(0, frag.GetInnerVerticesNum())) {
       messages.ForceContinue();
     }
 
-    ctx.curr_modified.swap(ctx.next_modified);
+    ctx.curr_modified.Swap(ctx.next_modified);
 #ifdef PROFILING
     ctx.postprocess_time += GetCurrentTime();
 #endif
@@ -150,34 +154,56 @@ class WCC : public ParallelAppBase<FRAG_T, WCCContext<FRAG_T>>,
                message_manager_t& messages) {
     using vid_t = typename context_t::vid_t;
 
-    ctx.next_modified.parallel_clear(thread_num());
+    ctx.next_modified.ParallelClear(thread_num());
 
+    vid_t ivnum = frag.GetInnerVerticesNum();
+    size_t active_num =
+        ctx.curr_modified.ParallelPartialCount(thread_num(), 0, ivnum);
+    double rate = static_cast<double>(active_num) / static_cast<double>(ivnum);
+    // If active vertices are few, pushing will be used. Vertices updated by
+    // messages are not known yet, they are counted in after being applied.
+    if (rate > 0.1) {
 #ifdef PROFILING
-    ctx.preprocess_time -= GetCurrentTime();
+      ctx.preprocess_time -= GetCurrentTime();
 #endif
-    // aggregate messages
-    messages.ParallelProcess<fragment_t, vid_t>(
-        thread_num(), frag, [&ctx](int tid, vertex_t u, vid_t msg) {
-          if (ctx.comp_id[u] > msg) {
-            atomic_min(ctx.comp_id[u], msg);
-            ctx.curr_modified.set_bit(u.GetValue());
-          }
-        });
-
+      // aggregate messages, each vertex is updated by its owner thread only.
+      messages.ParallelProcessByOwner<fragment_t, vid_t>(
+          thread_num(), frag, [&ctx](int tid, vertex_t u, vid_t msg) {
+            if (ctx.comp_id[u] > msg) {
+              ctx.comp_id[u] = msg;
+              ctx.curr_modified.Insert(u, tid);
+            }
+          });
 #ifdef PROFILING
-    ctx.preprocess_time += GetCurrentTime();
-    ctx.eval_time -= GetCurrentTime();
+      ctx.preprocess_time += GetCurrentTime();
+      ctx.eval_time -= GetCurrentTime();
 #endif
-
-    vid_t ivnum = frag.GetInnerVerticesNum();
-    double rate = static_cast<double>(ctx.curr_modified.parallel_partial_count(
-                      thread_num(), 0, ivnum)) /
-                  static_cast<double>(ivnum);
-    // If active vertices are few, pushing will be used.
-    if (rate > 0.1) {
       PropagateLabelPull(frag, ctx, messages);
     } else {
-      PropagateLabelPush(frag, ctx, messages);
+#ifdef PROFILING
+      ctx.eval_time -= GetCurrentTime();
+#endif
+      ctx.recv_modified.Clear();
+      // messages are processed in background while pushing labels of the
+      // vertices modified locally in the last round, then labels of the
+      // vertices updated by messages are pushed.
+      messages.StartParallelProcess<fragment_t, vid_t>(
+          1, frag, [&ctx](int tid, vertex_t u, vid_t msg) {
+            if (ctx.comp_id[u] > msg) {
+              atomic_min(ctx.comp_id[u], msg);
+              ctx.recv_modified.Insert(u, tid);
+            }
+          });
+      PropagateLabelPush(frag, ctx, messages, ctx.curr_modified);
+      messages.WaitParallelProcess();
+      active_num +=
+          ctx.recv_modified.ParallelPartialCount(thread_num(), 0, ivnum);
+      rate = static_cast<double>(active_num) / static_cast<double>(ivnum);
+      if (rate > 0.1) {
+        PropagateLabelPull(frag, ctx, messages);
+      } else {
+        PropagateLabelPush(frag, ctx, messages, ctx.recv_modified);
+      }
     }
 
 #ifdef PROFILING
@@ -185,11 +211,11 @@ class WCC : public ParallelAppBase<FRAG_T, WCCContext<FRAG_T>>,
     ctx.postprocess_time -= GetCurrentTime();
 #endif
 
-    if (!ctx.next_modified.partial_empty(0, frag.GetInnerVerticesNum())) {
+    if (!ctx.next_modified.PartialEmpty(0, frag.GetInnerVerticesNum())) {
       messages.ForceContinue();
     }
 
-    ctx.curr_modified.swap(ctx.next_modified);
+    ctx.curr_modified.Swap(ctx.next_modified);
 
 #ifdef PROFILING
     ctx.postprocess_time += GetCurrentTime();
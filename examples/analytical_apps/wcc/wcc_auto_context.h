@@ -42,24 +42,10 @@ class WCCAutoContext : public ContextBase<FRAG_T> {
     local_comp_id.Init(inner_vertices, std::numeric_limits<uint32_t>::max());
 #ifdef WCC_USE_GID
     global_cluster_id.Init(vertices, std::numeric_limits<vid_t>::max(),
-                           [](vid_t& lhs, vid_t rhs) {
-                             if (lhs > rhs) {
-                               lhs = rhs;
-                               return true;
-                             } else {
-                               return false;
-                             }
-                           });
+                           MinAggregator<vid_t>());
 #else
     global_cluster_id.Init(vertices, std::numeric_limits<oid_t>::max(),
-                           [](oid_t& lhs, oid_t rhs) {
-                             if (lhs > rhs) {
-                               lhs = rhs;
-                               return true;
-                             } else {
-                               return false;
-                             }
-                           });
+                           MinAggregator<oid_t>());
 #endif
     messages.RegisterSyncBuffer(frag, &global_cluster_id,
                                 MessageStrategy::kSyncOnOuterVertex);
@@ -76,10 +62,10 @@ class WCCAutoContext : public ContextBase<FRAG_T> {
   VertexArray<vid_t, vid_t> local_comp_id;
 #ifdef WCC_USE_GID
   std::vector<vid_t> global_comp_id;
-  SyncBuffer<vid_t, vid_t> global_cluster_id;
+  SyncBuffer<vid_t, vid_t, MinAggregator<vid_t>> global_cluster_id;
 #else
   std::vector<oid_t> global_comp_id;
-  SyncBuffer<oid_t, vid_t> global_cluster_id;
+  SyncBuffer<oid_t, vid_t, MinAggregator<oid_t>> global_cluster_id;
 #endif
 };
 }  // namespace grape
@@ -34,9 +34,6 @@ class WCCContext : public ContextBase<FRAG_T> {
     auto vertices = frag.Vertices();
 
     comp_id.Init(vertices);
-
-    curr_modified.init(frag.GetVerticesNum());
-    next_modified.init(frag.GetVerticesNum());
   }
 
   void Output(const FRAG_T& frag, std::ostream& os) {
@@ -53,7 +50,9 @@ class WCCContext : public ContextBase<FRAG_T> {
 
   VertexArray<vid_t, vid_t> comp_id;
 
-  Bitset curr_modified, next_modified;
+  Frontier<vid_t> curr_modified, next_modified;
+  // vertices updated by messages in a round.
+  Frontier<vid_t> recv_modified;
 
 #ifdef PROFILING
   double preprocess_time = 0;
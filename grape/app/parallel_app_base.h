@@ -27,6 +27,9 @@ class ParallelMessageManager;
 template <typename T>
 class ParallelWorker;
 
+template <typename T>
+class AsyncWorker;
+
 /**
  * @brief ParallelAppBase is a base class for parallel apps. Users can process
  * messages in a more flexible way in this kind of app. It contains an
@@ -44,6 +47,10 @@ class ParallelAppBase {
   static constexpr MessageStrategy message_strategy =
       MessageStrategy::kSyncOnOuterVertex;
   static constexpr LoadStrategy load_strategy = LoadStrategy::kOnlyOut;
+  // Whether IncEval leaves the results unchanged when no messages are
+  // received and no one forced to continue, which allows the termination vote
+  // to be overlapped with the next round.
+  static constexpr bool speculative_termination = false;
 
   using message_manager_t = ParallelMessageManager;
 
@@ -90,6 +97,18 @@ class ParallelAppBase {
     return std::shared_ptr<worker_t>(new worker_t(app, frag));    \
   }
 
+#define INSTALL_ASYNC_PARALLEL_WORKER(APP_T, CONTEXT_T, FRAG_T)   \
+ public:                                                          \
+  using fragment_t = FRAG_T;                                      \
+  using context_t = CONTEXT_T;                                    \
+  using message_manager_t = ParallelMessageManager;               \
+  using worker_t = AsyncWorker<APP_T>;                            \
+  virtual ~APP_T() {}                                             \
+  static std::shared_ptr<worker_t> CreateWorker(                  \
+      std::shared_ptr<APP_T> app, std::shared_ptr<FRAG_T> frag) { \
+    return std::shared_ptr<worker_t>(new worker_t(app, frag));    \
+  }
+
 }  // namespace grape
 
 #endif  // GRAPE_APP_PARALLEL_APP_BASE_H_
@@ -0,0 +1,535 @@
+/** Copyright 2020 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef GRAPE_COMMUNICATION_SHM_TRANSPORT_H_
+#define GRAPE_COMMUNICATION_SHM_TRANSPORT_H_
+
+#include <fcntl.h>
+#include <mpi.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "grape/config.h"
+#include "grape/serialization/out_archive.h"
+#include "grape/worker/comm_spec.h"
+
+namespace grape {
+
+/**
+ * @brief A single-producer single-consumer ring of bytes, placed in memory
+ * shared by two processes. Positions are counted in bytes since the ring was
+ * created, so the ring is full when tail - head equals the capacity.
+ */
+class ShmRing {
+  static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+                "Rings in shared memory require lock-free 64-bit atomics.");
+
+  struct Header {
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+  };
+
+ public:
+  ShmRing() : header_(NULL), data_(NULL), capacity_(0) {}
+
+  /**
+   * @brief Size of the memory holding a ring of capacity bytes.
+   */
+  static size_t SegmentSize(size_t capacity) {
+    return sizeof(Header) + capacity;
+  }
+
+  /**
+   * @brief Initialize a ring in the memory at base.
+   */
+  static void Create(char* base) {
+    Header* header = new (base) Header();
+    header->head.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_release);
+  }
+
+  /**
+   * @brief Attach to a ring created at base.
+   */
+  void Attach(char* base, size_t capacity) {
+    header_ = reinterpret_cast<Header*>(base);
+    data_ = base + sizeof(Header);
+    capacity_ = capacity;
+  }
+
+  /**
+   * @brief Write as many bytes as the free space allows, never blocks.
+   *
+   * @return Number of bytes written.
+   */
+  size_t Write(const char* buf, size_t size) {
+    uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+    uint64_t head = header_->head.load(std::memory_order_acquire);
+    size_t num = std::min(size, capacity_ - static_cast<size_t>(tail - head));
+    if (num == 0) {
+      return 0;
+    }
+    size_t offset = tail % capacity_;
+    size_t first = std::min(num, capacity_ - offset);
+    memcpy(data_ + offset, buf, first);
+    memcpy(data_, buf + first, num - first);
+    header_->tail.store(tail + num, std::memory_order_release);
+    return num;
+  }
+
+  /**
+   * @brief Read as many bytes as available, never blocks.
+   *
+   * @return Number of bytes read.
+   */
+  size_t Read(char* buf, size_t size) {
+    uint64_t head = header_->head.load(std::memory_order_relaxed);
+    uint64_t tail = header_->tail.load(std::memory_order_acquire);
+    size_t num = std::min(size, static_cast<size_t>(tail - head));
+    if (num == 0) {
+      return 0;
+    }
+    size_t offset = head % capacity_;
+    size_t first = std::min(num, capacity_ - offset);
+    memcpy(buf, data_ + offset, first);
+    memcpy(buf + first, data_, num - first);
+    header_->head.store(head + num, std::memory_order_release);
+    return num;
+  }
+
+ private:
+  Header* header_;
+  char* data_;
+  size_t capacity_;
+};
+
+/**
+ * @brief A transport of messages between workers on the same host, through
+ * POSIX shared memory instead of MPI.
+ *
+ * Each worker creates a segment holding a ring per co-located worker, which
+ * is written by that worker only. Messages are framed by their sizes and
+ * tags, and streamed through the rings, so messages larger than a ring are
+ * fine. A progress thread drives the posted sends and receives of all the
+ * peers, as MPI does for nonblocking operations, so that a worker blocked in
+ * other communications never stalls the peers reading from it.
+ *
+ * Receives are either posted with buffers, matched with messages from a peer
+ * in order, or delivered to a handler if it is set, for receivers unaware of
+ * the sizes and numbers of messages.
+ */
+class ShmTransport {
+  static constexpr int kSpinCount = 1024;
+  static constexpr int kSleepMicros = 50;
+
+  struct Frame {
+    uint64_t size;
+    int64_t tag;
+  };
+
+  struct Op {
+    Op()
+        : src(NULL),
+          dst(NULL),
+          capacity(0),
+          allocate(false),
+          done(0),
+          finished(false) {
+      frame.size = 0;
+      frame.tag = 0;
+    }
+
+    const char* src;
+    char* dst;
+    size_t capacity;
+    // whether the payload is received into arc, allocated on the frame.
+    bool allocate;
+    Frame frame;
+    // bytes of the frame and the payload transferred.
+    size_t done;
+    // payload of a message delivered to the handler, or posted without a
+    // buffer.
+    OutArchive arc;
+    std::atomic<bool> finished;
+  };
+
+  struct Peer {
+    ShmRing in;
+    ShmRing out;
+    // posted operations guarded by mutex_, and the ongoing ones.
+    std::deque<std::shared_ptr<Op>> sends;
+    std::deque<std::shared_ptr<Op>> recvs;
+    std::shared_ptr<Op> send;
+    std::shared_ptr<Op> recv;
+  };
+
+ public:
+  static constexpr size_t kDefaultRingSize = 4 * 1024 * 1024;
+
+  using Request = std::shared_ptr<Op>;
+  using handler_t = std::function<void(fid_t, int, OutArchive&&)>;
+
+  ShmTransport() : fid_(0), fnum_(0), ring_size_(0), stop_(true) {}
+
+  ~ShmTransport() { Finalize(); }
+
+  ShmTransport(const ShmTransport&) = delete;
+  ShmTransport& operator=(const ShmTransport&) = delete;
+
+  /**
+   * @brief Connect to the workers sharing memory with this worker, which is
+   * collective over the communicator of comm_spec. The transport is left
+   * disabled on all the workers if any of them failed to create its segment.
+   *
+   * @param comm_spec
+   * @param ring_size Capacity in bytes of the ring from each peer.
+   */
+  void Init(const CommSpec& comm_spec, size_t ring_size = kDefaultRingSize) {
+    Finalize();
+    MPI_Comm comm = comm_spec.comm();
+    int worker_id = comm_spec.worker_id();
+    fid_ = comm_spec.fid();
+    fnum_ = comm_spec.fnum();
+    ring_size_ = (std::max(ring_size, sizeof(Frame)) + 63) / 64 * 64;
+
+    MPI_Comm local_comm;
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, worker_id, MPI_INFO_NULL,
+                        &local_comm);
+    int local_num, local_id;
+    MPI_Comm_size(local_comm, &local_num);
+    MPI_Comm_rank(local_comm, &local_id);
+    std::vector<int> local_workers(local_num);
+    MPI_Allgather(&worker_id, 1, MPI_INT, local_workers.data(), 1, MPI_INT,
+                  local_comm);
+
+    char prefix[64];
+    memset(prefix, 0, sizeof(prefix));
+    if (worker_id == 0) {
+      int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+      std::string name = "/grape_" + std::to_string(getpid()) + "_" +
+                         std::to_string(now);
+      strncpy(prefix, name.c_str(), sizeof(prefix) - 1);
+    }
+    MPI_Bcast(prefix, sizeof(prefix), MPI_CHAR, 0, comm);
+
+    size_t segment_size = ShmRing::SegmentSize(ring_size_) * local_num;
+    std::string name = segmentName(prefix, worker_id);
+    char* own = local_num > 1 ? mapSegment(name, segment_size, true) : NULL;
+    int ok = (local_num == 1 || own != NULL) ? 1 : 0;
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, comm);
+    if (!ok || local_num == 1) {
+      if (own != NULL) {
+        munmap(own, segment_size);
+        shm_unlink(name.c_str());
+      }
+      if (!ok) {
+        LOG(WARNING) << "Shared memory transport is disabled.";
+      }
+      MPI_Comm_free(&local_comm);
+      return;
+    }
+    segments_.emplace_back(own, segment_size);
+
+    peers_.resize(fnum_);
+    for (int i = 0; i < local_num; ++i) {
+      if (i == local_id) {
+        continue;
+      }
+      char* remote = mapSegment(segmentName(prefix, local_workers[i]),
+                                segment_size, false);
+      CHECK(remote != NULL);
+      segments_.emplace_back(remote, segment_size);
+
+      fid_t fid = comm_spec.WorkerToFrag(local_workers[i]);
+      size_t slot_size = ShmRing::SegmentSize(ring_size_);
+      peers_[fid].reset(new Peer());
+      peers_[fid]->in.Attach(own + i * slot_size, ring_size_);
+      peers_[fid]->out.Attach(remote + local_id * slot_size, ring_size_);
+      local_fids_.push_back(fid);
+    }
+    MPI_Barrier(local_comm);
+    shm_unlink(name.c_str());
+    MPI_Comm_free(&local_comm);
+
+    stop_.store(false, std::memory_order_release);
+    progress_thread_ = std::thread(&ShmTransport::progressRoutine, this);
+  }
+
+  /**
+   * @brief Stop the progress thread and unmap the rings, posted operations
+   * are expected to be finished.
+   */
+  void Finalize() {
+    if (progress_thread_.joinable()) {
+      stop_.store(true, std::memory_order_release);
+      progress_thread_.join();
+    }
+    for (auto& pair : segments_) {
+      munmap(pair.first, pair.second);
+    }
+    segments_.clear();
+    peers_.clear();
+    local_fids_.clear();
+  }
+
+  /**
+   * @brief Whether any co-located worker is connected.
+   */
+  bool Enabled() const { return !local_fids_.empty(); }
+
+  /**
+   * @brief Whether messages to and from a fragment go through the transport.
+   */
+  bool IsLocal(fid_t fid) const {
+    return fid < peers_.size() && peers_[fid] != nullptr;
+  }
+
+  /**
+   * @brief Deliver all the messages received to handler(src_fid, tag, arc)
+   * on the progress thread, instead of matching posted receives. It is
+   * expected to be set before Init.
+   */
+  void SetHandler(const handler_t& handler) { handler_ = handler; }
+
+  /**
+   * @brief Post a message to a co-located fragment, buf should be kept alive
+   * until the request is finished.
+   */
+  Request PostSend(fid_t fid, const char* buf, size_t size, int tag = 0) {
+    Request req = std::make_shared<Op>();
+    req->src = buf;
+    req->frame.size = size;
+    req->frame.tag = tag;
+    std::unique_lock<std::mutex> lk(mutex_);
+    peers_[fid]->sends.push_back(req);
+    return req;
+  }
+
+  /**
+   * @brief Post a receive of the next message from a co-located fragment,
+   * which is no larger than capacity.
+   */
+  Request PostRecv(fid_t fid, char* buf, size_t capacity) {
+    Request req = std::make_shared<Op>();
+    req->dst = buf;
+    req->capacity = capacity;
+    std::unique_lock<std::mutex> lk(mutex_);
+    peers_[fid]->recvs.push_back(req);
+    return req;
+  }
+
+  /**
+   * @brief Post a receive of the next message from a co-located fragment of
+   * any size, which is taken by Payload once the request is finished.
+   */
+  Request PostRecv(fid_t fid) {
+    Request req = std::make_shared<Op>();
+    req->allocate = true;
+    std::unique_lock<std::mutex> lk(mutex_);
+    peers_[fid]->recvs.push_back(req);
+    return req;
+  }
+
+  static OutArchive& Payload(const Request& req) { return req->arc; }
+
+  static bool Test(const Request& req) {
+    return req->finished.load(std::memory_order_acquire);
+  }
+
+  static void Wait(const Request& req) {
+    int spin = 0;
+    while (!Test(req)) {
+      backoff(spin++);
+    }
+  }
+
+  /**
+   * @brief Wait for all the requests and clear them, null ones are skipped.
+   */
+  static void WaitAll(std::vector<Request>& reqs) {
+    for (auto& req : reqs) {
+      if (req != nullptr) {
+        Wait(req);
+      }
+    }
+    reqs.clear();
+  }
+
+ private:
+  static void backoff(int spin) {
+    if (spin < kSpinCount) {
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(kSleepMicros));
+    }
+  }
+
+  static std::string segmentName(const char* prefix, int worker_id) {
+    return std::string(prefix) + "_" + std::to_string(worker_id);
+  }
+
+  char* mapSegment(const std::string& name, size_t size, bool create) {
+    int fd = create ? shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600)
+                    : shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+      return NULL;
+    }
+    // ftruncate only makes a sparse file, reserve the pages up front so that
+    // a small /dev/shm fails here, instead of raising SIGBUS on first touch.
+    if (create && (ftruncate(fd, size) != 0 ||
+                   posix_fallocate(fd, 0, size) != 0)) {
+      close(fd);
+      shm_unlink(name.c_str());
+      return NULL;
+    }
+    void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) {
+      if (create) {
+        shm_unlink(name.c_str());
+      }
+      return NULL;
+    }
+    char* base = static_cast<char*>(ptr);
+    if (create) {
+      size_t slot_size = ShmRing::SegmentSize(ring_size_);
+      for (size_t offset = 0; offset < size; offset += slot_size) {
+        ShmRing::Create(base + offset);
+      }
+    }
+    return base;
+  }
+
+  void progressRoutine() {
+    int spin = 0;
+    while (!stop_.load(std::memory_order_acquire)) {
+      bool busy = false;
+      for (fid_t fid : local_fids_) {
+        Peer& peer = *peers_[fid];
+        busy |= progressSend(peer);
+        busy |= progressRecv(fid, peer);
+      }
+      if (busy) {
+        spin = 0;
+      } else {
+        backoff(spin++);
+      }
+    }
+  }
+
+  // returns whether any bytes are transferred.
+  bool progressSend(Peer& peer) {
+    if (peer.send == nullptr) {
+      std::unique_lock<std::mutex> lk(mutex_);
+      if (peer.sends.empty()) {
+        return false;
+      }
+      peer.send = std::move(peer.sends.front());
+      peer.sends.pop_front();
+    }
+    Op& op = *peer.send;
+    size_t before = op.done;
+    if (op.done < sizeof(Frame)) {
+      const char* frame = reinterpret_cast<const char*>(&op.frame);
+      op.done += peer.out.Write(frame + op.done, sizeof(Frame) - op.done);
+    }
+    if (op.done >= sizeof(Frame)) {
+      size_t sent = op.done - sizeof(Frame);
+      op.done += peer.out.Write(op.src + sent, op.frame.size - sent);
+    }
+    bool ret = (op.done != before);
+    if (op.done == sizeof(Frame) + op.frame.size) {
+      op.finished.store(true, std::memory_order_release);
+      peer.send.reset();
+    }
+    return ret;
+  }
+
+  bool progressRecv(fid_t fid, Peer& peer) {
+    if (peer.recv == nullptr) {
+      if (handler_) {
+        peer.recv = std::make_shared<Op>();
+        peer.recv->allocate = true;
+      } else {
+        std::unique_lock<std::mutex> lk(mutex_);
+        if (peer.recvs.empty()) {
+          return false;
+        }
+        peer.recv = std::move(peer.recvs.front());
+        peer.recvs.pop_front();
+      }
+    }
+    Op& op = *peer.recv;
+    size_t before = op.done;
+    if (op.done < sizeof(Frame)) {
+      char* frame = reinterpret_cast<char*>(&op.frame);
+      op.done += peer.in.Read(frame + op.done, sizeof(Frame) - op.done);
+      if (op.done == sizeof(Frame)) {
+        if (op.allocate) {
+          op.arc.Allocate(op.frame.size);
+          op.dst = op.arc.GetBuffer();
+        } else {
+          CHECK_LE(op.frame.size, op.capacity);
+        }
+      }
+    }
+    if (op.done >= sizeof(Frame)) {
+      size_t got = op.done - sizeof(Frame);
+      op.done += peer.in.Read(op.dst + got, op.frame.size - got);
+    }
+    bool ret = (op.done != before);
+    if (op.done == sizeof(Frame) + op.frame.size) {
+      if (handler_) {
+        handler_(fid, static_cast<int>(op.frame.tag), std::move(op.arc));
+      }
+      op.finished.store(true, std::memory_order_release);
+      peer.recv.reset();
+    }
+    return ret;
+  }
+
+  fid_t fid_;
+  fid_t fnum_;
+  size_t ring_size_;
+
+  std::vector<std::unique_ptr<Peer>> peers_;
+  std::vector<fid_t> local_fids_;
+  std::vector<std::pair<char*, size_t>> segments_;
+
+  handler_t handler_;
+  std::mutex mutex_;
+  std::atomic<bool> stop_;
+  std::thread progress_thread_;
+};
+
+}  // namespace grape
+
+#endif  // GRAPE_COMMUNICATION_SHM_TRANSPORT_H_
@@ -54,8 +54,7 @@ class ShuffleUnit {
     MPI_Send(&size, static_cast<int>(sizeof(size_t)), MPI_CHAR, dst_worker_id,
              tag, comm);
     if (size) {
-      MPI_Send(buffer_.data(), static_cast<int>(size * sizeof(T)), MPI_CHAR,
-               dst_worker_id, tag, comm);
+      SendBytes(buffer_.data(), size * sizeof(T), dst_worker_id, tag, comm);
     }
   }
 
@@ -66,8 +65,8 @@ class ShuffleUnit {
              src_worker_id, tag, comm, MPI_STATUS_IGNORE);
     if (to_recv) {
       buffer_.resize(to_recv + old_size);
-      MPI_Recv(&buffer_[old_size], static_cast<int>(to_recv * sizeof(T)),
-               MPI_CHAR, src_worker_id, tag, comm, MPI_STATUS_IGNORE);
+      RecvBytes(&buffer_[old_size], to_recv * sizeof(T), src_worker_id, tag,
+                comm);
     }
   }
 
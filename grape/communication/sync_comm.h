@@ -45,6 +45,91 @@ inline void FinalizeMPIComm() { MPI_Finalize(); }
 
 static const int chunk_size = 409600;
 
+/**
+ * Counts of MPI are ints, so a buffer of more than kMaxBytesCount bytes is
+ * described by one element of a derived datatype, which is made of chunks of
+ * kLargeBytesChunk bytes followed by the remainder. Receivers get the size of
+ * such a message with GetBytesCount, and may receive a message into a larger
+ * buffer, as with MPI_CHAR.
+ */
+static const size_t kMaxBytesCount = std::numeric_limits<int>::max();
+static const size_t kLargeBytesChunk = static_cast<size_t>(1) << 30;
+
+inline MPI_Datatype create_bytes_type(size_t size) {
+  size_t chunk_num = size / kLargeBytesChunk;
+  MPI_Datatype chunk_type, chunks_type, ret;
+  MPI_Type_contiguous(static_cast<int>(kLargeBytesChunk), MPI_CHAR,
+                      &chunk_type);
+  MPI_Type_contiguous(static_cast<int>(chunk_num), chunk_type, &chunks_type);
+  int lengths[2] = {1, static_cast<int>(size % kLargeBytesChunk)};
+  MPI_Aint displs[2] = {0, static_cast<MPI_Aint>(chunk_num * kLargeBytesChunk)};
+  MPI_Datatype types[2] = {chunks_type, MPI_CHAR};
+  MPI_Type_create_struct(2, lengths, displs, types, &ret);
+  MPI_Type_commit(&ret);
+  MPI_Type_free(&chunk_type);
+  MPI_Type_free(&chunks_type);
+  return ret;
+}
+
+// invoke func(count, datatype) with the description of size bytes. Derived
+// datatypes can be freed once communications are posted, MPI defers it
+// until they complete.
+template <typename FUNC_T>
+inline void with_bytes_type(size_t size, const FUNC_T& func) {
+  if (size <= kMaxBytesCount) {
+    func(static_cast<int>(size), MPI_CHAR);
+  } else {
+    MPI_Datatype type = create_bytes_type(size);
+    func(1, type);
+    MPI_Type_free(&type);
+  }
+}
+
+inline void SendBytes(const void* buf, size_t size, int dst_worker_id,
+                      int tag, MPI_Comm comm) {
+  with_bytes_type(size, [&](int count, MPI_Datatype type) {
+    MPI_Send(buf, count, type, dst_worker_id, tag, comm);
+  });
+}
+
+inline void RecvBytes(void* buf, size_t size, int src_worker_id, int tag,
+                      MPI_Comm comm) {
+  with_bytes_type(size, [&](int count, MPI_Datatype type) {
+    MPI_Recv(buf, count, type, src_worker_id, tag, comm, MPI_STATUS_IGNORE);
+  });
+}
+
+inline void IsendBytes(const void* buf, size_t size, int dst_worker_id,
+                       int tag, MPI_Comm comm, MPI_Request* req) {
+  with_bytes_type(size, [&](int count, MPI_Datatype type) {
+    MPI_Isend(buf, count, type, dst_worker_id, tag, comm, req);
+  });
+}
+
+inline void IssendBytes(const void* buf, size_t size, int dst_worker_id,
+                        int tag, MPI_Comm comm, MPI_Request* req) {
+  with_bytes_type(size, [&](int count, MPI_Datatype type) {
+    MPI_Issend(buf, count, type, dst_worker_id, tag, comm, req);
+  });
+}
+
+inline void IrecvBytes(void* buf, size_t size, int src_worker_id, int tag,
+                       MPI_Comm comm, MPI_Request* req) {
+  with_bytes_type(size, [&](int count, MPI_Datatype type) {
+    MPI_Irecv(buf, count, type, src_worker_id, tag, comm, req);
+  });
+}
+
+/**
+ * @brief Size of a probed message in bytes, which may exceed the range of
+ * int.
+ */
+inline size_t GetBytesCount(const MPI_Status& status) {
+  MPI_Count count;
+  MPI_Get_elements_x(&status, MPI_CHAR, &count);
+  return static_cast<size_t>(count);
+}
+
 template <typename T>
 static inline void send_buffer(const T* ptr, size_t len, int dst_worker_id,
                                MPI_Comm comm, int tag) {
@@ -31,6 +31,7 @@ limitations under the License.
 #include "grape/fragment/rebalancer.h"
 #include "grape/graph/edge.h"
 #include "grape/graph/vertex.h"
+#include "grape/utils/cpu_topology.h"
 #include "grape/utils/vertex_array.h"
 #include "grape/utils/concurrent_queue.h"
 #include "grape/worker/comm_spec.h"
@@ -108,11 +109,21 @@ class BasicFragmentLoader<
     rebalance_vertex_factor_ = rebalance_vertex_factor;
   }
 
+  /**
+   * @brief Bind the communication threads of the loader to the given cpus,
+   * they will float over all the cpus if the list is empty.
+   */
+  void SetCommCpuList(const std::vector<uint32_t>& cpu_list) {
+    comm_cpu_list_ = cpu_list;
+  }
+
   void Start() {
     vertex_recv_thread_ =
         std::thread(&BasicFragmentLoader::vertexRecvRoutine, this);
     edge_recv_thread_ =
         std::thread(&BasicFragmentLoader::edgeRecvRoutine, this);
+    BindThreadToCpus(vertex_recv_thread_, comm_cpu_list_);
+    BindThreadToCpus(edge_recv_thread_, comm_cpu_list_);
     recv_thread_running_ = true;
   }
 
@@ -350,8 +361,8 @@ class BasicFragmentLoader<
         for (auto v : range) {
           gid_list.push_back(fragment->Vertex2Gid(v));
         }
-        MPI_Send(&gid_list[0], sizeof(vid_t) * gid_list.size(), MPI_CHAR,
-                 dst_worker_id, 0, comm_spec_.comm());
+        SendBytes(gid_list.data(), sizeof(vid_t) * gid_list.size(),
+                  dst_worker_id, 0, comm_spec_.comm());
       }
     });
 
@@ -366,12 +377,15 @@ class BasicFragmentLoader<
         VertexRange<vid_t> range(offsets[0], offsets[1]);
         gid_list.clear();
         gid_list.resize(range.size());
-        MPI_Recv(&gid_list[0], gid_list.size() * sizeof(vid_t), MPI_CHAR,
-                 src_worker_id, 0, comm_spec_.comm(), MPI_STATUS_IGNORE);
+        RecvBytes(gid_list.data(), gid_list.size() * sizeof(vid_t),
+                  src_worker_id, 0, comm_spec_.comm());
         fragment->SetupMirrorInfo(src_fid, range, gid_list);
       }
     });
 
+    BindThreadToCpus(send_thread, comm_cpu_list_);
+    BindThreadToCpus(recv_thread, comm_cpu_list_);
+
     recv_thread.join();
     send_thread.join();
   }
@@ -390,8 +404,8 @@ class BasicFragmentLoader<
         for (auto v : vertices) {
           arc << fragment->GetData(v);
         }
-        MPI_Send(arc.GetBuffer(), arc.GetSize(), MPI_CHAR, dst_worker_id, 0,
-                 comm_spec_.comm());
+        SendBytes(arc.GetBuffer(), arc.GetSize(), dst_worker_id, 0,
+                  comm_spec_.comm());
       }
     });
 
@@ -402,12 +416,10 @@ class BasicFragmentLoader<
         fid_t src_fid = comm_spec_.WorkerToFrag(src_worker_id);
         MPI_Status status;
         MPI_Probe(src_worker_id, 0, comm_spec_.comm(), &status);
-        int count;
-        MPI_Get_count(&status, MPI_CHAR, &count);
         arc.Clear();
-        arc.Allocate(count);
-        MPI_Recv(arc.GetBuffer(), arc.GetSize(), MPI_CHAR, src_worker_id, 0,
-                 comm_spec_.comm(), MPI_STATUS_IGNORE);
+        arc.Allocate(GetBytesCount(status));
+        RecvBytes(arc.GetBuffer(), arc.GetSize(), src_worker_id, 0,
+                  comm_spec_.comm());
         auto range = fragment->OuterVertices(src_fid);
         for (auto v : range) {
           vdata_t val;
@@ -417,12 +429,16 @@ class BasicFragmentLoader<
       }
     });
 
+    BindThreadToCpus(send_thread, comm_cpu_list_);
+    BindThreadToCpus(recv_thread, comm_cpu_list_);
+
     recv_thread.join();
     send_thread.join();
   }
 
  private:
   CommSpec comm_spec_;
+  std::vector<uint32_t> comm_cpu_list_;
   std::shared_ptr<vertex_map_t> vm_ptr_;
 
   std::vector<ShuffleOutPair<oid_t, vdata_t>> vertices_to_frag_;
@@ -511,11 +527,20 @@ class BasicFragmentLoader<
     rebalance_vertex_factor_ = rebalance_vertex_factor;
   }
 
+  /**
+   * @brief Bind the communication threads of the loader to the given cpus,
+   * they will float over all the cpus if the list is empty.
+   */
+  void SetCommCpuList(const std::vector<uint32_t>& cpu_list) {
+    comm_cpu_list_ = cpu_list;
+  }
+
   void Start() {
     got_edges_queues_.SetProducerNum(2);
 
     edge_recv_thread_ =
         std::thread(&BasicFragmentLoader::edgeRecvRoutine, this);
+    BindThreadToCpus(edge_recv_thread_, comm_cpu_list_);
     recv_thread_running_ = true;
 
     vm_ptr_->Init();
@@ -779,8 +804,8 @@ class BasicFragmentLoader<
         for (auto v : range) {
           gid_list.push_back(fragment->Vertex2Gid(v));
         }
-        MPI_Send(&gid_list[0], sizeof(vid_t) * gid_list.size(), MPI_CHAR,
-                 dst_worker_id, 0, comm_spec_.comm());
+        SendBytes(gid_list.data(), sizeof(vid_t) * gid_list.size(),
+                  dst_worker_id, 0, comm_spec_.comm());
       }
     });
 
@@ -795,18 +820,22 @@ class BasicFragmentLoader<
         VertexRange<vid_t> range(offsets[0], offsets[1]);
         gid_list.clear();
         gid_list.resize(range.size());
-        MPI_Recv(&gid_list[0], gid_list.size() * sizeof(vid_t), MPI_CHAR,
-                 src_worker_id, 0, comm_spec_.comm(), MPI_STATUS_IGNORE);
+        RecvBytes(gid_list.data(), gid_list.size() * sizeof(vid_t),
+                  src_worker_id, 0, comm_spec_.comm());
         fragment->SetupMirrorInfo(src_fid, range, gid_list);
       }
     });
 
+    BindThreadToCpus(send_thread, comm_cpu_list_);
+    BindThreadToCpus(recv_thread, comm_cpu_list_);
+
     recv_thread.join();
     send_thread.join();
   }
 
  private:
   CommSpec comm_spec_;
+  std::vector<uint32_t> comm_cpu_list_;
   std::shared_ptr<vertex_map_t> vm_ptr_;
 
   std::vector<ShuffleOutTriple<oid_t, oid_t, edata_t>> edges_to_frag_;
@@ -47,6 +47,9 @@ struct LoadGraphSpec {
   bool deserialize;
   std::string deserialization_prefix;
 
+  // cpus for the communication threads of the loader, empty for no binding.
+  std::vector<uint32_t> comm_cpu_list;
+
   void set_directed(bool val = true) { directed = val; }
   void set_rebalance(bool flag, int weight) {
     rebalance = flag;
@@ -62,6 +65,10 @@ struct LoadGraphSpec {
     deserialize = flag;
     deserialization_prefix = prefix;
   }
+
+  void set_comm_cpu_list(const std::vector<uint32_t>& cpus) {
+    comm_cpu_list = cpus;
+  }
 };
 
 inline LoadGraphSpec DefaultLoadGraphSpec() {
@@ -71,6 +78,7 @@ inline LoadGraphSpec DefaultLoadGraphSpec() {
   spec.rebalance_vertex_factor = 0;
   spec.serialize = false;
   spec.deserialize = false;
+  spec.comm_cpu_list.clear();
   return spec;
 }
 
@@ -171,6 +179,7 @@ class EVFragmentLoader {
     basic_fragment_loader_.SetPartitioner(std::move(partitioner));
     basic_fragment_loader_.SetRebalance(spec.rebalance,
                                         spec.rebalance_vertex_factor);
+    basic_fragment_loader_.SetCommCpuList(spec.comm_cpu_list);
 
     basic_fragment_loader_.Start();
 
@@ -917,6 +917,26 @@ class ImmutableEdgecutFragment
                             oeoffset_[v.GetValue() + 1]);
   }
 
+  /**
+   * @brief Returns the CSR offsets of incoming adjacent lists, the incoming
+   * edges of inner vertex v are [offsets[v], offsets[v + 1]).
+   *
+   * @return The incoming offsets, indexed by local id of inner vertices.
+   */
+  inline const nbr_t* const* GetIncomingOffsets() const {
+    return ieoffset_.data();
+  }
+
+  /**
+   * @brief Returns the CSR offsets of outgoing adjacent lists, the outgoing
+   * edges of inner vertex v are [offsets[v], offsets[v + 1]).
+   *
+   * @return The outgoing offsets, indexed by local id of inner vertices.
+   */
+  inline const nbr_t* const* GetOutgoingOffsets() const {
+    return oeoffset_.data();
+  }
+
   /**
    * @brief Returns the incoming adjacent inner vertices of v.
    *
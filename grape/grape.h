@@ -20,12 +20,14 @@ limitations under the License.
 #include "grape/app/batch_shuffle_app_base.h"
 #include "grape/app/context_base.h"
 #include "grape/app/parallel_app_base.h"
+#include "grape/parallel/async_message_manager.h"
 #include "grape/parallel/auto_parallel_message_manager.h"
 #include "grape/parallel/batch_shuffle_message_manager.h"
 #include "grape/parallel/default_message_manager.h"
 #include "grape/parallel/parallel_message_manager.h"
 #include "grape/utils/atomic_ops.h"
 #include "grape/utils/vertex_array.h"
+#include "grape/worker/async_worker.h"
 #include "grape/worker/auto_worker.h"
 #include "grape/worker/batch_shuffle_worker.h"
 #include "grape/worker/parallel_worker.h"
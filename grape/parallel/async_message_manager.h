@@ -0,0 +1,386 @@
+/** Copyright 2020 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef GRAPE_PARALLEL_ASYNC_MESSAGE_MANAGER_H_
+#define GRAPE_PARALLEL_ASYNC_MESSAGE_MANAGER_H_
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "grape/parallel/parallel_message_manager.h"
+
+namespace grape {
+
+/**
+ * @brief A message manager for the asynchronous execution of parallel apps,
+ * following the AAP model.
+ *
+ * Rounds are local to each worker, there is no global barrier between them.
+ * A worker starts a round as soon as it has received messages or it has local
+ * work to continue, i.e., ForceContinue, and the messages received so far are
+ * processed in the round with the interfaces of ParallelMessageManager. So it
+ * only works with apps whose results are independent of the rounds in which
+ * messages are processed, e.g., SSSP and WCC.
+ *
+ * With a staleness bound s > 0, a worker doesn't start its round t until all
+ * the other active workers reached round t - s + 1, so fast workers won't
+ * flood slow ones with messages computed on stale states. Idle workers, which
+ * wait for messages, don't block others.
+ *
+ * Termination is detected with Safra's algorithm. Each worker counts the
+ * blocks it sent minus the blocks it received, and turns black on receiving.
+ * A token travels along the ring of workers, and is passed on only by passive
+ * workers. The initiator, worker of fragment 0, announces termination once
+ * the token comes back white, with itself white and counters summing up to 0.
+ */
+class AsyncMessageManager : public ParallelMessageManager {
+  static constexpr int kDataTag = 1;
+  static constexpr int kTokenTag = 2;
+  static constexpr int kProgressTag = 3;
+  static constexpr int kTerminateTag = 4;
+
+  static constexpr int64_t kWhite = 0;
+  static constexpr int64_t kBlack = 1;
+  static constexpr int64_t kIdleStep = std::numeric_limits<int64_t>::max();
+
+  using control_t = std::array<int64_t, 2>;
+
+ public:
+  AsyncMessageManager() : staleness_(0) {}
+  ~AsyncMessageManager() override {}
+
+  /**
+   * @brief Set the staleness bound, 0 for unbounded.
+   */
+  void SetStaleness(int staleness) { staleness_ = staleness; }
+
+  /**
+   * @brief Number of rounds this worker evaluated.
+   */
+  int64_t Steps() const { return step_; }
+
+  /**
+   * @brief Inherit
+   */
+  void Init(MPI_Comm comm) override {
+    ParallelMessageManager::Init(comm);
+
+    step_ = 0;
+    idle_ = false;
+    terminated_ = false;
+    peer_steps_.clear();
+    peer_steps_.resize(fnum_, 0);
+
+    counter_ = 0;
+    black_ = false;
+    probing_ = false;
+    token_held_ = false;
+
+    incoming_.clear();
+  }
+
+  /**
+   * @brief Inherit
+   */
+  void Start() override {
+    startAsyncRecvThread();
+    startAsyncSendThread();
+  }
+
+  /**
+   * @brief Inherit
+   */
+  void StartARound() override {
+    auto& rq = recv_queues_[round_ % 2];
+    rq.SetProducerNum(1);
+    // messages from fast workers may arrive before PEval, which doesn't
+    // process messages, keep them for the first IncEval.
+    if (step_ != 0) {
+      std::unique_lock<std::mutex> lk(mutex_);
+      for (auto& arc : incoming_) {
+        rq.Put(std::move(arc));
+      }
+      incoming_.clear();
+    }
+    rq.DecProducerNum();
+
+    sent_size_ = 0;
+    force_continue_ = false;
+  }
+
+  /**
+   * @brief Inherit
+   */
+  void FinishARound() override {
+    CHECK(process_threads_.empty())
+        << "WaitParallelProcess is expected before the end of a round.";
+    sent_size_ = flushChannels();
+    flushSendingQueue();
+
+    auto& rq = recv_queues_[round_ % 2];
+    OutArchive arc;
+    while (rq.Get(arc)) {}
+    round_++;
+
+    std::unique_lock<std::mutex> lk(mutex_);
+    ++step_;
+    if (staleness_ > 0) {
+      broadcastControl(kProgressTag, control_t{{step_, 0}});
+    }
+  }
+
+  /**
+   * @brief Wait until this worker is allowed to start a round, or all the
+   * workers are passive and there are no messages in transit.
+   */
+  bool ToTerminate() override {
+    std::unique_lock<std::mutex> lk(mutex_);
+    while (!terminated_) {
+      if (force_continue_ || !incoming_.empty()) {
+        if (idle_) {
+          idle_ = false;
+          int64_t min_step = minPeerStep();
+          if (min_step != kIdleStep) {
+            step_ = std::max(step_, min_step);
+          }
+          if (staleness_ > 0) {
+            broadcastControl(kProgressTag, control_t{{step_, 0}});
+          }
+        }
+        if (staleness_ <= 0 || step_ - minPeerStep() < staleness_) {
+          return false;
+        }
+      } else {
+        if (!idle_) {
+          idle_ = true;
+          if (staleness_ > 0) {
+            broadcastControl(kProgressTag, control_t{{kIdleStep, 0}});
+          }
+        }
+        passToken();
+        if (terminated_) {
+          break;
+        }
+      }
+      cv_.wait_for(lk, std::chrono::milliseconds(1));
+    }
+    return true;
+  }
+
+  /**
+   * @brief Inherit
+   */
+  void Finalize() override {
+    sending_queue_.DecProducerNum();
+    send_thread_.join();
+    for (auto& control : controls_) {
+      MPI_Wait(&control.first, MPI_STATUS_IGNORE);
+    }
+    controls_.clear();
+    MPI_Barrier(comm_);
+    stopRecvThread();
+
+    MPI_Comm_free(&comm_);
+    comm_ = NULL_COMM;
+  }
+
+ private:
+  // Safra's rules on the token, invoked by a passive worker with mutex_ held.
+  void passToken() {
+    if (fnum_ == 1) {
+      terminated_ = true;
+      return;
+    }
+    fid_t next = (fid_ + 1) % fnum_;
+    if (fid_ == 0) {
+      if (!probing_) {
+        probing_ = true;
+        black_ = false;
+        sendControl(next, kTokenTag, control_t{{0, kWhite}});
+      } else if (token_held_) {
+        token_held_ = false;
+        if (token_[1] == kWhite && !black_ && token_[0] + counter_ == 0) {
+          terminated_ = true;
+          broadcastControl(kTerminateTag, control_t{{0, 0}});
+        } else {
+          black_ = false;
+          sendControl(next, kTokenTag, control_t{{0, kWhite}});
+        }
+      }
+    } else if (token_held_) {
+      token_held_ = false;
+      control_t token{{token_[0] + counter_, token_[1]}};
+      if (black_) {
+        token[1] = kBlack;
+      }
+      sendControl(next, kTokenTag, token);
+      black_ = false;
+    }
+  }
+
+  int64_t minPeerStep() const {
+    int64_t ret = kIdleStep;
+    for (fid_t i = 0; i < fnum_; ++i) {
+      if (i != fid_) {
+        ret = std::min(ret, peer_steps_[i]);
+      }
+    }
+    return ret;
+  }
+
+  void sendControl(fid_t fid, int tag, const control_t& control) {
+    while (!controls_.empty()) {
+      int flag;
+      MPI_Test(&controls_.front().first, &flag, MPI_STATUS_IGNORE);
+      if (!flag) {
+        break;
+      }
+      controls_.pop_front();
+    }
+    controls_.emplace_back(MPI_REQUEST_NULL, control);
+    auto& back = controls_.back();
+    MPI_Issend(back.second.data(), sizeof(control_t), MPI_CHAR,
+               comm_spec_.FragToWorker(fid), tag, comm_, &back.first);
+  }
+
+  void broadcastControl(int tag, const control_t& control) {
+    for (fid_t i = 0; i < fnum_; ++i) {
+      if (i != fid_) {
+        sendControl(i, tag, control);
+      }
+    }
+  }
+
+  // wait until the send thread posted all the blocks put before, so that
+  // they are counted for termination detection.
+  void flushSendingQueue() {
+    sending_queue_.Put(std::make_pair(fnum_, InArchive()));
+    int tag;
+    CHECK(sent_rounds_.Get(tag));
+  }
+
+  void startAsyncSendThread() {
+    sending_queue_.SetProducerNum(1);
+    sent_rounds_.SetProducerNum(1);
+    send_thread_ = std::thread([this]() {
+      std::vector<MPI_Request> reqs;
+      std::pair<fid_t, InArchive> item;
+      while (sending_queue_.Get(item)) {
+        if (item.first == fnum_) {
+          MPI_Waitall(reqs.size(), reqs.data(), MPI_STATUSES_IGNORE);
+          reqs.clear();
+          to_others_.clear();
+          sent_rounds_.Put(0);
+        } else if (item.second.GetSize() == 0) {
+          continue;
+        } else if (item.first == fid_) {
+          std::unique_lock<std::mutex> lk(mutex_);
+          incoming_.emplace_back(std::move(item.second));
+          cv_.notify_all();
+        } else {
+          {
+            std::unique_lock<std::mutex> lk(mutex_);
+            ++counter_;
+          }
+          MPI_Request req;
+          IssendBytes(item.second.GetBuffer(), item.second.GetSize(),
+                      comm_spec_.FragToWorker(item.first), kDataTag, comm_,
+                      &req);
+          reqs.push_back(req);
+          to_others_.emplace_back(std::move(item.second));
+        }
+      }
+      MPI_Waitall(reqs.size(), reqs.data(), MPI_STATUSES_IGNORE);
+      to_others_.clear();
+    });
+    BindThreadToCpus(send_thread_, comm_cpu_list_);
+  }
+
+  void startAsyncRecvThread() {
+    recv_thread_ = std::thread([this]() {
+      MPI_Status status;
+      while (true) {
+        MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, comm_, &status);
+        int src = status.MPI_SOURCE;
+        int tag = status.MPI_TAG;
+        if (src == comm_spec_.worker_id()) {
+          MPI_Recv(NULL, 0, MPI_CHAR, src, tag, comm_, MPI_STATUS_IGNORE);
+          return;
+        }
+        if (tag == kDataTag) {
+          size_t count = GetBytesCount(status);
+          OutArchive arc(count);
+          RecvBytes(arc.GetBuffer(), count, src, tag, comm_);
+          std::unique_lock<std::mutex> lk(mutex_);
+          black_ = true;
+          --counter_;
+          incoming_.emplace_back(std::move(arc));
+        } else {
+          control_t control;
+          MPI_Recv(control.data(), sizeof(control_t), MPI_CHAR, src, tag,
+                   comm_, MPI_STATUS_IGNORE);
+          std::unique_lock<std::mutex> lk(mutex_);
+          if (tag == kTokenTag) {
+            token_ = control;
+            token_held_ = true;
+          } else if (tag == kProgressTag) {
+            peer_steps_[comm_spec_.WorkerToFrag(src)] = control[0];
+          } else if (tag == kTerminateTag) {
+            terminated_ = true;
+          }
+        }
+        cv_.notify_all();
+      }
+    });
+    BindThreadToCpus(recv_thread_, comm_cpu_list_);
+  }
+
+  int staleness_;
+
+  // guards the states below, which are shared with the send/recv threads.
+  std::mutex mutex_;
+  std::condition_variable cv_;
+
+  std::deque<OutArchive> incoming_;
+
+  int64_t step_;
+  bool idle_;
+  bool terminated_;
+  std::vector<int64_t> peer_steps_;
+
+  // blocks sent minus blocks received.
+  int64_t counter_;
+  bool black_;
+  bool probing_;
+  bool token_held_;
+  control_t token_;
+
+  // control messages being sent, with their buffers.
+  std::deque<std::pair<MPI_Request, control_t>> controls_;
+};
+
+}  // namespace grape
+
+#endif  // GRAPE_PARALLEL_ASYNC_MESSAGE_MANAGER_H_
@@ -16,12 +16,14 @@ limitations under the License.
 #ifndef GRAPE_PARALLEL_AUTO_PARALLEL_MESSAGE_MANAGER_H_
 #define GRAPE_PARALLEL_AUTO_PARALLEL_MESSAGE_MANAGER_H_
 
+#include <string.h>
+
 #include <algorithm>
+#include <atomic>
 #include <functional>
 #include <iterator>
-#include <map>
 #include <memory>
-#include <typeinfo>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -29,10 +31,12 @@ limitations under the License.
 #include "grape/fragment/edgecut_fragment_base.h"
 #include "grape/parallel/default_message_manager.h"
 #include "grape/parallel/message_manager_base.h"
+#include "grape/parallel/parallel_engine.h"
 #include "grape/parallel/sync_buffer.h"
 #include "grape/serialization/in_archive.h"
 #include "grape/serialization/out_archive.h"
 #include "grape/types.h"
+#include "grape/utils/thread_pool.h"
 #include "grape/worker/comm_spec.h"
 
 namespace grape {
@@ -42,7 +46,9 @@ namespace grape {
  *
  * After registering the vertex array and message strategy as a sync buffer,
  * message generation and ingestion can be applied by message manager
- * automatically.
+ * automatically. Both of them are done by multiple threads, messages are
+ * generated into thread local buffers in one pass over the vertices, and
+ * ingested in partitions of vertices.
  */
 template <typename FRAG_T>
 class AutoParallelMessageManager : public DefaultMessageManager {
@@ -56,14 +62,98 @@ class AutoParallelMessageManager : public DefaultMessageManager {
   using Base = DefaultMessageManager;
   using vid_t = typename FRAG_T::vid_t;
 
-  struct ap_event {
-    ap_event(const FRAG_T& f, ISyncBuffer* b, MessageStrategy m, int e)
-        : fragment(f), buffer(b), message_strategy(m), event_id(e) {}
+  // Number of vertices or messages fetched by a thread at a time.
+  static constexpr size_t kChunkSize = 4096;
+
+  class ISyncEvent {
+   public:
+    virtual ~ISyncEvent() {}
+
+    // whether any inner vertex is updated.
+    virtual bool Updated() const = 0;
 
-    const FRAG_T& fragment;
-    ISyncBuffer* buffer;
-    MessageStrategy message_strategy;
-    int event_id;
+    virtual void Send() = 0;
+
+    // receive message_num messages from arc.
+    virtual void Recv(OutArchive& arc, size_t message_num) = 0;
+
+    // aggregate the messages received in this round.
+    virtual void Aggregate() = 0;
+  };
+
+  /**
+   * @brief A registered sync buffer with its concrete type, so messages are
+   * generated and aggregated without type dispatching, and the aggregator is
+   * invoked directly.
+   */
+  template <typename BUFFER_T>
+  class SyncEvent : public ISyncEvent {
+    using buffer_t = BUFFER_T;
+    using T = typename BUFFER_T::value_t;
+
+   public:
+    SyncEvent(AutoParallelMessageManager* mm, const FRAG_T& frag,
+              buffer_t* buffer, MessageStrategy strategy, int event_id)
+        : mm_(mm),
+          frag_(frag),
+          buffer_(buffer),
+          strategy_(strategy),
+          event_id_(event_id) {}
+
+    bool Updated() const override {
+      return buffer_->updated(0, frag_.InnerVertices().size());
+    }
+
+    void Send() override {
+      if (strategy_ == MessageStrategy::kSyncOnOuterVertex) {
+        mm_->syncOnOuterVertexSend(frag_, buffer_, event_id_);
+      } else {
+        mm_->syncOnInnerVertexSend(frag_, buffer_, event_id_, strategy_);
+      }
+    }
+
+    void Recv(OutArchive& arc, size_t message_num) override {
+      recv(arc, message_num, typename std::is_pod<T>::type());
+    }
+
+    void Aggregate() override { aggregate(typename std::is_pod<T>::type()); }
+
+   private:
+    // values of POD types are laid out in archives as raw bytes, blocks of
+    // them are aggregated by threads later.
+    void recv(OutArchive& arc, size_t message_num, std::true_type) {
+      blocks_.emplace_back(static_cast<char*>(arc.GetBytes(
+                               message_num * (sizeof(vid_t) + sizeof(T)))),
+                           message_num);
+    }
+
+    void recv(OutArchive& arc, size_t message_num, std::false_type) {
+      vid_t gid;
+      T rhs;
+      Vertex<vid_t> v;
+      while (message_num--) {
+        arc >> gid >> rhs;
+        frag_.Gid2Vertex(gid, v);
+        buffer_->Aggregate(v, std::move(rhs));
+      }
+    }
+
+    void aggregate(std::true_type) {
+      if (!blocks_.empty()) {
+        mm_->template aggregateBlocks<T>(frag_, buffer_, blocks_);
+        blocks_.clear();
+      }
+    }
+
+    void aggregate(std::false_type) {}
+
+    AutoParallelMessageManager* mm_;
+    const FRAG_T& frag_;
+    buffer_t* buffer_;
+    MessageStrategy strategy_;
+    int event_id_;
+
+    std::vector<std::pair<char*, size_t>> blocks_;
   };
 
  public:
@@ -99,252 +189,307 @@ class AutoParallelMessageManager : public DefaultMessageManager {
   using Base::ForceContinue;
 
   /**
-   * @brief Register a buffer to be sync automatically between rounds.
+   * @brief Register a buffer to be sync automatically between rounds. Values
+   * of any serializable type can be synchronized, and those of POD types are
+   * aggregated by multiple threads.
    *
+   * @tparam BUFFER_T Type of the buffer, a SyncBuffer or a
+   * ConcurrentSyncBuffer.
    * @param frag
    * @param buffer
    * @param strategy
    */
-  inline void RegisterSyncBuffer(const FRAG_T& frag, ISyncBuffer* buffer,
+  template <typename BUFFER_T>
+  inline void RegisterSyncBuffer(const FRAG_T& frag, BUFFER_T* buffer,
                                  MessageStrategy strategy) {
+    static_assert(std::is_base_of<ISyncBuffer, BUFFER_T>::value,
+                  "A sync buffer is expected.");
+    if (strategy != MessageStrategy::kSyncOnOuterVertex &&
+        strategy != MessageStrategy::kAlongEdgeToOuterVertex &&
+        strategy != MessageStrategy::kAlongOutgoingEdgeToOuterVertex &&
+        strategy != MessageStrategy::kAlongIncomingEdgeToOuterVertex) {
+      LOG(FATAL) << "Unexpected message stratety "
+                 << underlying_value(strategy);
+    }
     int event_id = auto_parallel_events_.size();
-    auto_parallel_events_.emplace_back(frag, buffer, strategy, event_id);
+    auto_parallel_events_.emplace_back(
+        new SyncEvent<BUFFER_T>(this, frag, buffer, strategy, event_id));
   }
 
- private:
-  void aggregateAutoMessages() {
-    std::map<int, ap_event*> event_map;
-    for (auto& event : auto_parallel_events_) {
-      event_map.emplace(event.event_id, &event);
+  /**
+   * @brief Set the threads generating and ingesting the messages of sync
+   * buffers.
+   *
+   * @param spec
+   */
+  void SetParallelEngineSpec(const ParallelEngineSpec& spec) {
+    if (spec.affinity && !spec.cpu_list.empty()) {
+      thread_pool_.Start(spec.thread_num, spec.cpu_list);
+    } else {
+      thread_pool_.Start(spec.thread_num);
     }
+  }
 
-    int event_id;
-    while (Base::GetMessage<int>(event_id)) {
-      ap_event* event = event_map.at(event_id);
-
-      auto& i_ec_frag = event->fragment;
-      if (event->message_strategy == MessageStrategy::kSyncOnOuterVertex ||
-          event->message_strategy == MessageStrategy::kAlongEdgeToOuterVertex ||
-          event->message_strategy ==
-              MessageStrategy::kAlongOutgoingEdgeToOuterVertex ||
-          event->message_strategy ==
-              MessageStrategy::kAlongIncomingEdgeToOuterVertex) {
-        if (event->buffer->GetTypeId() == typeid(double)) {
-          syncOnVertexRecv<double>(i_ec_frag, event->buffer);
-        } else if (event->buffer->GetTypeId() == typeid(uint32_t)) {
-          syncOnVertexRecv<uint32_t>(i_ec_frag, event->buffer);
-        } else if (event->buffer->GetTypeId() == typeid(int32_t)) {
-          syncOnVertexRecv<int32_t>(i_ec_frag, event->buffer);
-        } else if (event->buffer->GetTypeId() == typeid(int64_t)) {
-          syncOnVertexRecv<int64_t>(i_ec_frag, event->buffer);
-        } else if (event->buffer->GetTypeId() ==
-                   typeid(std::vector<uint32_t>)) {
-          syncOnVertexRecv<std::vector<uint32_t>>(i_ec_frag, event->buffer);
-        } else {
-          LOG(FATAL) << "Unexpected data type "
-                     << event->buffer->GetTypeId().name();
-        }
-      } else {
-        LOG(FATAL) << "Unexpected message stratety "
-                   << underlying_value(event->message_strategy);
+ private:
+  // Messages of a sync buffer to a fragment are a header of the event id and
+  // the number of messages, followed by (gid, value) pairs.
+  void aggregateAutoMessages() {
+    for (fid_t src = 0; src < Base::fnum(); ++src) {
+      auto& arc = Base::to_recv_[src];
+      while (!arc.Empty()) {
+        int event_id;
+        size_t message_num;
+        arc >> event_id >> message_num;
+        auto_parallel_events_.at(event_id)->Recv(arc, message_num);
       }
     }
+    for (auto& event : auto_parallel_events_) {
+      event->Aggregate();
+    }
   }
 
   void generateAutoMessages() {
-    for (auto& event_ref : auto_parallel_events_) {
-      ap_event* event = &event_ref;
-      auto& i_ec_frag = event->fragment;
-      auto inner_size = i_ec_frag.InnerVertices().size();
-      if (event->buffer->updated(0, inner_size)) {
+    for (auto& event : auto_parallel_events_) {
+      if (event->Updated()) {
         ForceContinue();
         break;
       }
     }
+    for (auto& event : auto_parallel_events_) {
+      event->Send();
+    }
+  }
 
-    for (auto& event_ref : auto_parallel_events_) {
-      ap_event* event = &event_ref;
-
-      auto& i_ec_frag = event->fragment;
-      if (event->message_strategy == MessageStrategy::kSyncOnOuterVertex) {
-        if (event->buffer->GetTypeId() == typeid(double)) {
-          syncOnOuterVertexSend<double>(i_ec_frag, event->buffer,
-                                        event->event_id);
-        } else if (event->buffer->GetTypeId() == typeid(uint32_t)) {
-          syncOnOuterVertexSend<uint32_t>(i_ec_frag, event->buffer,
-                                          event->event_id);
-        } else if (event->buffer->GetTypeId() == typeid(int32_t)) {
-          syncOnOuterVertexSend<int32_t>(i_ec_frag, event->buffer,
-                                         event->event_id);
-        } else if (event->buffer->GetTypeId() == typeid(int64_t)) {
-          syncOnOuterVertexSend<int64_t>(i_ec_frag, event->buffer,
-                                         event->event_id);
-        } else {
-          LOG(FATAL) << "Unexpected data type for auto parallelization: "
-                     << event->buffer->GetTypeId().name();
-        }
-      } else if (event->message_strategy ==
-                     MessageStrategy::kAlongEdgeToOuterVertex ||
-                 event->message_strategy ==
-                     MessageStrategy::kAlongIncomingEdgeToOuterVertex ||
-                 event->message_strategy ==
-                     MessageStrategy::kAlongOutgoingEdgeToOuterVertex) {
-        if (event->buffer->GetTypeId() == typeid(double)) {
-          syncOnInnerVertexSend<double>(i_ec_frag, event->buffer,
-                                        event->event_id,
-                                        event->message_strategy);
-        } else if (event->buffer->GetTypeId() == typeid(uint32_t)) {
-          syncOnInnerVertexSend<uint32_t>(i_ec_frag, event->buffer,
-                                          event->event_id,
-                                          event->message_strategy);
-        } else if (event->buffer->GetTypeId() == typeid(int32_t)) {
-          syncOnInnerVertexSend<int32_t>(i_ec_frag, event->buffer,
-                                         event->event_id,
-                                         event->message_strategy);
-        } else if (event->buffer->GetTypeId() == typeid(int64_t)) {
-          syncOnInnerVertexSend<int64_t>(i_ec_frag, event->buffer,
-                                         event->event_id,
-                                         event->message_strategy);
-        } else if (event->buffer->GetTypeId() ==
-                   typeid(std::vector<uint32_t>)) {
-          syncOnInnerVertexSend<std::vector<uint32_t>>(i_ec_frag, event->buffer,
-                                                       event->event_id,
-                                                       event->message_strategy);
-        } else {
-          LOG(FATAL) << "Unexpected data type for auto parallelization: "
-                     << event->buffer->GetTypeId().name();
-        }
-      } else {
-        LOG(FATAL) << "Unexpected message stratety "
-                   << underlying_value(event->message_strategy);
-      }
+  uint32_t threadNum() {
+    if (!thread_pool_.Started()) {
+      thread_pool_.Start(1);
     }
+    return thread_pool_.thread_num();
   }
 
-  template <typename T>
-  inline void syncOnInnerVertexSend(const FRAG_T& frag, ISyncBuffer* buffer,
-                                    int event_id,
-                                    MessageStrategy message_strategy) {
-    auto* bptr = dynamic_cast<SyncBuffer<T, vid_t>*>(buffer);
-    auto inner_vertices = frag.InnerVertices();
-    std::vector<size_t> message_num(Base::fnum(), 0);
-
-    if (message_strategy == MessageStrategy::kAlongEdgeToOuterVertex) {
-      for (auto v : inner_vertices) {
-        if (bptr->IsUpdated(v)) {
-          DestList dsts = frag.IOEDests(v);
-          fid_t* ptr = dsts.begin;
-          while (ptr != dsts.end) {
-            ++message_num[*(ptr++)];
-          }
+  // invoke func(tid, i) on [0, n) concurrently, indices are fetched by
+  // threads in chunks dynamically.
+  template <typename FUNC_T>
+  void parallelFor(size_t n, size_t chunk_size, const FUNC_T& func) {
+    threadNum();
+    std::atomic<size_t> cur(0);
+    thread_pool_.RunTask([&cur, &func, n, chunk_size](uint32_t tid) {
+      while (true) {
+        size_t cur_beg = std::min(cur.fetch_add(chunk_size), n);
+        size_t cur_end = std::min(cur_beg + chunk_size, n);
+        if (cur_beg == cur_end) {
+          break;
         }
-      }
-    } else if (message_strategy ==
-               MessageStrategy::kAlongIncomingEdgeToOuterVertex) {
-      for (auto v : inner_vertices) {
-        if (bptr->IsUpdated(v)) {
-          DestList dsts = frag.IEDests(v);
-          fid_t* ptr = dsts.begin;
-          while (ptr != dsts.end) {
-            ++message_num[*(ptr++)];
-          }
+        for (size_t i = cur_beg; i < cur_end; ++i) {
+          func(tid, i);
         }
       }
-    } else if (message_strategy ==
-               MessageStrategy::kAlongOutgoingEdgeToOuterVertex) {
-      for (auto v : inner_vertices) {
-        if (bptr->IsUpdated(v)) {
-          DestList dsts = frag.OEDests(v);
-          fid_t* ptr = dsts.begin;
-          while (ptr != dsts.end) {
-            ++message_num[*(ptr++)];
-          }
-        }
-      }
-    }
+    });
+  }
+
+  // invoke func(tid, v) on updated vertices in range concurrently, by chunks
+  // of kChunkSize vertices.
+  template <typename BUFFER_T, typename FUNC_T>
+  void forEachUpdated(BUFFER_T* bptr, const VertexRange<vid_t>& range,
+                      const FUNC_T& func) {
+    vid_t begin = range.begin().GetValue();
+    vid_t end = range.end().GetValue();
+    size_t chunk_size = kChunkSize;
+    parallelFor((range.size() + chunk_size - 1) / chunk_size, 1,
+                [bptr, &func, begin, end, chunk_size](uint32_t tid,
+                                                      size_t chunk) {
+                  vid_t chunk_begin = begin + chunk * chunk_size;
+                  vid_t chunk_end = std::min(
+                      static_cast<vid_t>(chunk_begin + chunk_size), end);
+                  bptr->ForEachUpdated(
+                      VertexRange<vid_t>(chunk_begin, chunk_end),
+                      [tid, &func](Vertex<vid_t> v) { func(tid, v); });
+                });
+  }
 
-    for (fid_t i = 0; i < Base::fnum(); i++) {
-      if (message_num[i] > 0) {
-        Base::SendToFragment<int>(i, event_id);
-        Base::SendToFragment<size_t>(i, message_num[i]);
+  void resetThreadBuffers() {
+    uint32_t thread_num = threadNum();
+    thread_buffers_.resize(thread_num);
+    thread_message_num_.resize(thread_num);
+    for (uint32_t tid = 0; tid < thread_num; ++tid) {
+      thread_buffers_[tid].resize(Base::fnum());
+      for (auto& arc : thread_buffers_[tid]) {
+        arc.Clear();
       }
+      thread_message_num_[tid].clear();
+      thread_message_num_[tid].resize(Base::fnum(), 0);
     }
+  }
 
-    if (message_strategy == MessageStrategy::kAlongEdgeToOuterVertex) {
-      for (auto v : inner_vertices) {
-        if (bptr->IsUpdated(v)) {
-          Base::SendMsgThroughEdges(frag, v, bptr->GetValue(v));
-          bptr->Reset(v);
-        }
+  // Append the messages generated by threads to the send buffers. Offsets of
+  // the thread buffers are computed by a prefix sum, then they are copied
+  // concurrently.
+  void gatherThreadBuffers(int event_id) {
+    fid_t fnum = Base::fnum();
+    size_t thread_num = thread_buffers_.size();
+    std::vector<size_t> offsets(thread_num * fnum, 0);
+    for (fid_t fid = 0; fid < fnum; ++fid) {
+      size_t message_num = 0;
+      for (size_t tid = 0; tid < thread_num; ++tid) {
+        message_num += thread_message_num_[tid][fid];
       }
-    } else if (message_strategy ==
-               MessageStrategy::kAlongIncomingEdgeToOuterVertex) {
-      for (auto v : inner_vertices) {
-        if (bptr->IsUpdated(v)) {
-          Base::SendMsgThroughIEdges(frag, v, bptr->GetValue(v));
-          bptr->Reset(v);
-        }
+      if (message_num == 0) {
+        continue;
       }
-    } else if (message_strategy ==
-               MessageStrategy::kAlongOutgoingEdgeToOuterVertex) {
-      for (auto v : inner_vertices) {
-        if (bptr->IsUpdated(v)) {
-          Base::SendMsgThroughOEdges(frag, v, bptr->GetValue(v));
-          bptr->Reset(v);
-        }
+      auto& arc = Base::to_send_[fid];
+      arc << event_id << message_num;
+      size_t offset = arc.GetSize();
+      for (size_t tid = 0; tid < thread_num; ++tid) {
+        offsets[tid * fnum + fid] = offset;
+        offset += thread_buffers_[tid][fid].GetSize();
       }
+      arc.Resize(offset);
     }
+    parallelFor(thread_num * fnum, 1,
+                [this, fnum, &offsets](uint32_t tid, size_t i) {
+                  auto& src = thread_buffers_[i / fnum][i % fnum];
+                  if (src.GetSize() != 0) {
+                    memcpy(Base::to_send_[i % fnum].GetBuffer() + offsets[i],
+                           src.GetBuffer(), src.GetSize());
+                  }
+                });
   }
 
-  template <typename T>
-  inline void syncOnOuterVertexSend(const FRAG_T& frag, ISyncBuffer* buffer,
-                                    int event_id) {
-    auto* bptr = dynamic_cast<SyncBuffer<T, vid_t>*>(buffer);
-    auto inner_vertices = frag.InnerVertices();
-    auto outer_vertices = frag.OuterVertices();
-    std::vector<size_t> message_num(Base::fnum(), 0);
+  template <typename BUFFER_T>
+  inline void syncOnInnerVertexSend(const FRAG_T& frag, BUFFER_T* bptr,
+                                    int event_id,
+                                    MessageStrategy message_strategy) {
+    resetThreadBuffers();
+    forEachUpdated(
+        bptr, frag.InnerVertices(),
+        [this, &frag, bptr, message_strategy](uint32_t tid, Vertex<vid_t> v) {
+          DestList dsts =
+              message_strategy == MessageStrategy::kAlongEdgeToOuterVertex
+                  ? frag.IOEDests(v)
+                  : (message_strategy ==
+                             MessageStrategy::kAlongIncomingEdgeToOuterVertex
+                         ? frag.IEDests(v)
+                         : frag.OEDests(v));
+          vid_t gid = frag.GetInnerVertexGid(v);
+          const auto& value = bptr->GetValue(v);
+          auto& arcs = thread_buffers_[tid];
+          auto& message_num = thread_message_num_[tid];
+          fid_t* ptr = dsts.begin;
+          while (ptr != dsts.end) {
+            fid_t fid = *(ptr++);
+            arcs[fid] << gid << value;
+            ++message_num[fid];
+          }
+          bptr->Reset(v);
+        });
+    gatherThreadBuffers(event_id);
+  }
 
-    for (auto v : inner_vertices) {
-      bptr->Reset(v);
-    }
+  template <typename BUFFER_T>
+  inline void syncOnOuterVertexSend(const FRAG_T& frag, BUFFER_T* bptr,
+                                    int event_id) {
+    forEachUpdated(bptr, frag.InnerVertices(),
+                   [bptr](uint32_t tid, Vertex<vid_t> v) { bptr->Reset(v); });
+
+    resetThreadBuffers();
+    forEachUpdated(bptr, frag.OuterVertices(),
+                   [this, &frag, bptr](uint32_t tid, Vertex<vid_t> v) {
+                     fid_t fid = frag.GetFragId(v);
+                     thread_buffers_[tid][fid]
+                         << frag.GetOuterVertexGid(v) << bptr->GetValue(v);
+                     ++thread_message_num_[tid][fid];
+                     bptr->Reset(v);
+                   });
+    gatherThreadBuffers(event_id);
+  }
 
-    for (auto v : outer_vertices) {
-      if (bptr->IsUpdated(v)) {
-        fid_t fid = frag.GetFragId(v);
-        ++message_num[fid];
+  // Aggregate blocks of fixed size messages concurrently. Messages are
+  // scattered into partitions of vertices, one for each thread, keeping their
+  // orders in blocks, so messages to a vertex are aggregated by one thread in
+  // the same order as the sequential ingestion.
+  template <typename T, typename BUFFER_T>
+  inline void aggregateBlocks(
+      const FRAG_T& frag, BUFFER_T* bptr,
+      const std::vector<std::pair<char*, size_t>>& blocks) {
+    static constexpr size_t kRecordSize = sizeof(vid_t) + sizeof(T);
+    size_t thread_num = threadNum();
+
+    // split blocks into pieces of at most kChunkSize messages.
+    size_t chunk_size = kChunkSize;
+    std::vector<std::pair<char*, size_t>> pieces;
+    for (auto& block : blocks) {
+      for (size_t i = 0; i < block.second; i += chunk_size) {
+        pieces.emplace_back(block.first + i * kRecordSize,
+                            std::min(chunk_size, block.second - i));
       }
     }
 
-    for (fid_t i = 0; i < Base::fnum(); i++) {
-      if (message_num[i] > 0) {
-        Base::SendToFragment<int>(i, event_id);
-        Base::SendToFragment<size_t>(i, message_num[i]);
+    auto vertices = frag.Vertices();
+    uint64_t vbegin = vertices.begin().GetValue();
+    uint64_t vnum = std::max(static_cast<uint64_t>(vertices.size()),
+                             static_cast<uint64_t>(1));
+    size_t piece_num = pieces.size();
+    std::vector<vid_t> lids(piece_num * kChunkSize);
+    std::vector<size_t> counts(piece_num * thread_num, 0);
+    parallelFor(piece_num, 1,
+                [&](uint32_t tid, size_t piece) {
+                  const char* ptr = pieces[piece].first;
+                  vid_t* piece_lids = &lids[piece * kChunkSize];
+                  size_t* piece_counts = &counts[piece * thread_num];
+                  Vertex<vid_t> v;
+                  for (size_t i = 0; i < pieces[piece].second; ++i) {
+                    vid_t gid;
+                    memcpy(&gid, ptr, sizeof(vid_t));
+                    frag.Gid2Vertex(gid, v);
+                    piece_lids[i] = v.GetValue();
+                    ++piece_counts[(v.GetValue() - vbegin) * thread_num / vnum];
+                    ptr += kRecordSize;
+                  }
+                });
+
+    // offsets of pieces in partitions, ordered by partitions then pieces.
+    std::vector<size_t> offsets(piece_num * thread_num);
+    std::vector<size_t> partition_offsets(thread_num + 1, 0);
+    size_t offset = 0;
+    for (size_t part = 0; part < thread_num; ++part) {
+      partition_offsets[part] = offset;
+      for (size_t piece = 0; piece < piece_num; ++piece) {
+        offsets[piece * thread_num + part] = offset;
+        offset += counts[piece * thread_num + part];
       }
     }
-
-    for (auto v : outer_vertices) {
-      if (bptr->IsUpdated(v)) {
-        Base::SyncStateOnOuterVertex(frag, v, bptr->GetValue(v));
-        bptr->Reset(v);
+    partition_offsets[thread_num] = offset;
+
+    std::vector<std::pair<vid_t, const char*>> messages(offset);
+    parallelFor(piece_num, 1,
+                [&](uint32_t tid, size_t piece) {
+                  const char* ptr = pieces[piece].first + sizeof(vid_t);
+                  const vid_t* piece_lids = &lids[piece * kChunkSize];
+                  size_t* piece_offsets = &offsets[piece * thread_num];
+                  for (size_t i = 0; i < pieces[piece].second; ++i) {
+                    size_t part =
+                        (piece_lids[i] - vbegin) * thread_num / vnum;
+                    messages[piece_offsets[part]++] =
+                        std::make_pair(piece_lids[i], ptr);
+                    ptr += kRecordSize;
+                  }
+                });
+
+    parallelFor(thread_num, 1, [&](uint32_t tid, size_t part) {
+      for (size_t i = partition_offsets[part]; i < partition_offsets[part + 1];
+           ++i) {
+        T rhs;
+        memcpy(&rhs, messages[i].second, sizeof(T));
+        bptr->Aggregate(Vertex<vid_t>(messages[i].first), std::move(rhs));
       }
-    }
+    });
   }
 
-  template <typename T>
-  inline void syncOnVertexRecv(const FRAG_T& frag, ISyncBuffer* buffer) {
-    auto* bptr = dynamic_cast<SyncBuffer<T, vid_t>*>(buffer);
-
-    size_t message_num = 0;
-    T rhs;
-    Vertex<vid_t> v;
-    Base::GetMessage<size_t>(message_num);
-    while (message_num--) {
-      GetMessage(frag, v, rhs);
-      bptr->Aggregate(v, std::move(rhs));
-    }
-  }
+  std::vector<std::unique_ptr<ISyncEvent>> auto_parallel_events_;
 
-  std::vector<ap_event> auto_parallel_events_;
+  ThreadPool thread_pool_;
+  std::vector<std::vector<InArchive>> thread_buffers_;
+  std::vector<std::vector<size_t>> thread_message_num_;
 };  // namespace grape
 
 }  // namespace grape
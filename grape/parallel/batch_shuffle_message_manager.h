@@ -16,17 +16,104 @@ limitations under the License.
 #ifndef GRAPE_PARALLEL_BATCH_SHUFFLE_MESSAGE_MANAGER_H_
 #define GRAPE_PARALLEL_BATCH_SHUFFLE_MESSAGE_MANAGER_H_
 
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
 #include <memory>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
+#include "grape/communication/shm_transport.h"
 #include "grape/communication/sync_comm.h"
 #include "grape/parallel/message_manager_base.h"
+#include "grape/serialization/message_codec.h"
 #include "grape/utils/vertex_array.h"
 #include "grape/worker/comm_spec.h"
 
 namespace grape {
 
+/**
+ * @brief Lossy encoding of the values of mirrors to a fragment. Values are
+ * split into blocks of kBlockSize, each of which is encoded by LossyCodec,
+ * and a message is the types of blocks padded to 8 bytes, followed by the
+ * encoded blocks. Only floating-point values are encoded lossily.
+ *
+ * @tparam DATA_T
+ */
+template <typename DATA_T, typename Enable = void>
+struct LossyMirrorCodec {
+  static constexpr bool kEnabled = false;
+
+  static size_t MaxMessageSize(size_t num) { return 0; }
+
+  static void Encode(const DATA_T* values, size_t num, LossyCodecType type,
+                     double max_error, std::vector<char>& out,
+                     int thread_num) {
+    LOG(FATAL) << "Only floating-point values can be encoded lossily.";
+  }
+
+  static void Decode(const char* in, size_t num, char* out) {
+    LOG(FATAL) << "Only floating-point values can be encoded lossily.";
+  }
+};
+
+template <typename DATA_T>
+struct LossyMirrorCodec<
+    DATA_T,
+    typename std::enable_if<std::is_floating_point<DATA_T>::value>::type> {
+  using codec_t = LossyCodec<DATA_T>;
+  static constexpr bool kEnabled = true;
+  static constexpr size_t kBlockSize = 1024;
+
+  static size_t MaxMessageSize(size_t num) {
+    size_t block_num = (num + kBlockSize - 1) / kBlockSize;
+    return codec_t::Padded(block_num) + block_num * codec_t::MaxEncodedSize(
+                                                        kBlockSize);
+  }
+
+  static void Encode(const DATA_T* values, size_t num, LossyCodecType type,
+                     double max_error, std::vector<char>& out,
+                     int thread_num) {
+    size_t block_num = (num + kBlockSize - 1) / kBlockSize;
+    std::vector<LossyCodecType> types(block_num);
+    std::vector<size_t> offsets(block_num + 1);
+#pragma omp parallel for num_threads(thread_num)
+    for (size_t b = 0; b < block_num; ++b) {
+      size_t len = std::min(kBlockSize, num - b * kBlockSize);
+      types[b] = codec_t::Choose(values + b * kBlockSize, len, type, max_error);
+      offsets[b + 1] = codec_t::EncodedSize(types[b], len);
+    }
+    offsets[0] = codec_t::Padded(block_num);
+    for (size_t b = 0; b < block_num; ++b) {
+      offsets[b + 1] += offsets[b];
+    }
+
+    out.clear();
+    out.resize(offsets[block_num]);
+    memcpy(out.data(), types.data(), block_num);
+#pragma omp parallel for num_threads(thread_num)
+    for (size_t b = 0; b < block_num; ++b) {
+      size_t len = std::min(kBlockSize, num - b * kBlockSize);
+      codec_t::Encode(values + b * kBlockSize, len, types[b],
+                      out.data() + offsets[b]);
+    }
+  }
+
+  static void Decode(const char* in, size_t num, char* out) {
+    size_t block_num = (num + kBlockSize - 1) / kBlockSize;
+    const LossyCodecType* types = reinterpret_cast<const LossyCodecType*>(in);
+    const char* ptr = in + codec_t::Padded(block_num);
+    DATA_T* values = reinterpret_cast<DATA_T*>(out);
+    for (size_t b = 0; b < block_num; ++b) {
+      size_t len = std::min(kBlockSize, num - b * kBlockSize);
+      codec_t::Decode(ptr, len, types[b], values + b * kBlockSize);
+      ptr += codec_t::EncodedSize(types[b], len);
+    }
+  }
+};
+
 /**
  * @brief A kind of collective message manager.
  *
@@ -41,7 +128,14 @@ namespace grape {
  */
 class BatchShuffleMessageManager : public MessageManagerBase {
  public:
-  BatchShuffleMessageManager() : comm_(NULL_COMM) {}
+  BatchShuffleMessageManager()
+      : comm_(NULL_COMM),
+        delta_sync_(false),
+        codec_(LossyCodecType::kNone),
+        max_error_(0),
+        sync_mode_(SyncMode::kRaw),
+        elem_size_(0),
+        lossy_decoder_(NULL) {}
   ~BatchShuffleMessageManager() {
     if (ValidComm(comm_)) {
       MPI_Comm_free(&comm_);
@@ -59,11 +153,27 @@ class BatchShuffleMessageManager : public MessageManagerBase {
     fnum_ = comm_spec_.fnum();
 
     shuffle_out_buffers_.resize(fnum_);
+    recv_buffers_.resize(fnum_);
+    recv_targets_.resize(fnum_, NULL);
+    recv_nums_.resize(fnum_, 0);
+    mirror_values_.resize(fnum_);
+    outer_values_.resize(fnum_);
 
     recv_thread_ =
         std::thread(&BatchShuffleMessageManager::recvThreadRoutine, this);
   }
 
+  /**
+   * @brief Synchronize with co-located workers through shared memory, which
+   * is collective and expected after Init.
+   *
+   * @param ring_size Capacity in bytes of the ring from each co-located
+   * worker.
+   */
+  void EnableShmTransport(size_t ring_size = ShmTransport::kDefaultRingSize) {
+    shm_.Init(comm_spec_, ring_size);
+  }
+
   /**
    * @brief Inherit
    */
@@ -100,11 +210,14 @@ class BatchShuffleMessageManager : public MessageManagerBase {
       MPI_Waitall(send_reqs_.size(), &send_reqs_[0], MPI_STATUSES_IGNORE);
       send_reqs_.clear();
     }
+    ShmTransport::WaitAll(shm_send_reqs_);
 
     if (!recv_reqs_.empty()) {
       MPI_Waitall(recv_reqs_.size(), &recv_reqs_[0], MPI_STATUSES_IGNORE);
       recv_reqs_.clear();
     }
+    ShmTransport::WaitAll(shm_recv_reqs_);
+    shm_.Finalize();
 
     {
       size_t v = 1;
@@ -117,6 +230,45 @@ class BatchShuffleMessageManager : public MessageManagerBase {
     comm_ = NULL_COMM;
   }
 
+  /**
+   * @brief Enable or disable the delta mode of synchronization.
+   *
+   * In the delta mode, values shipped to each fragment are compared with the
+   * ones shipped last time. If a sparse encoding, i.e., a bitmap of changed
+   * mirrors followed by their values, is smaller than the dense values, only
+   * the changed values are shipped, and receivers patch their copies of
+   * the outer vertices. It suits converging algorithms where few values
+   * change in late rounds, at the cost of a comparison and an extra copy.
+   *
+   * Each call of SyncInnerVertices is expected to synchronize the same
+   * logical array in the delta mode.
+   *
+   * @param enable
+   */
+  void EnableDeltaSync(bool enable = true) {
+    delta_sync_ = enable;
+    for (auto& vec : mirror_values_) {
+      vec.clear();
+    }
+  }
+
+  /**
+   * @brief Set the lossy codec of synchronization, e.g., to ship doubles as
+   * floats, bfloat16s or 16-bit fixed-point numbers with a scale per block.
+   * Values are decoded into the outer vertices with an absolute error of at
+   * most max_error, and blocks violating the bound are shipped as they are.
+   *
+   * It works on floating-point arrays only, others are synchronized exactly.
+   * The delta mode is disabled when a lossy codec is set.
+   *
+   * @param codec
+   * @param max_error Bound of the absolute error, 0 for unbounded.
+   */
+  void SetLossyCodec(LossyCodecType codec, double max_error = 0) {
+    codec_ = codec;
+    max_error_ = max_error;
+  }
+
   /**
    * @brief Synchronize the inner vertices' data of a vertex array to their
    * mirrors.
@@ -139,21 +291,59 @@ class BatchShuffleMessageManager : public MessageManagerBase {
       MPI_Waitall(send_reqs_.size(), &send_reqs_[0], MPI_STATUSES_IGNORE);
       send_reqs_.clear();
     }
+    ShmTransport::WaitAll(shm_send_reqs_);
 
     if (!recv_reqs_.empty()) {
-      MPI_Waitall(recv_reqs_.size(), &recv_reqs_[0], MPI_STATUSES_IGNORE);
-      recv_reqs_.clear();
-      recv_from_.clear();
+      UpdateOuterVertices();
+    }
+
+    using lossy_codec_t = LossyMirrorCodec<DATA_T>;
+    if (codec_ != LossyCodecType::kNone && lossy_codec_t::kEnabled) {
+      sync_mode_ = SyncMode::kLossy;
+    } else if (delta_sync_) {
+      sync_mode_ = SyncMode::kDelta;
+    } else {
+      sync_mode_ = SyncMode::kRaw;
     }
+    elem_size_ = sizeof(DATA_T);
+    lossy_decoder_ = &lossy_codec_t::Decode;
 
     for (fid_t i = 1; i < fnum_; ++i) {
       fid_t src_fid = (fid_ + fnum_ - i) % fnum_;
       auto range = frag.OuterVertices(src_fid);
-      MPI_Request req;
-      MPI_Irecv(&data_in[range.begin()], range.size() * sizeof(DATA_T),
-                MPI_CHAR, comm_spec_.FragToWorker(src_fid), 0, comm_, &req);
+      MPI_Request req = MPI_REQUEST_NULL;
+      ShmTransport::Request shm_req;
+      if (sync_mode_ == SyncMode::kRaw) {
+        char* buf = reinterpret_cast<char*>(&data_in[range.begin()]);
+        size_t size = range.size() * sizeof(DATA_T);
+        if (shm_.IsLocal(src_fid)) {
+          shm_req = shm_.PostRecv(src_fid, buf, size);
+        } else {
+          IrecvBytes(buf, size, comm_spec_.FragToWorker(src_fid), 0, comm_,
+                     &req);
+        }
+      } else {
+        auto& vec = recv_buffers_[src_fid];
+        if (sync_mode_ == SyncMode::kDelta) {
+          vec.resize(sizeof(size_t) + range.size() * sizeof(DATA_T));
+          outer_values_[src_fid].resize(range.size() * sizeof(DATA_T));
+        } else {
+          vec.resize(lossy_codec_t::MaxMessageSize(range.size()));
+        }
+        recv_targets_[src_fid] =
+            reinterpret_cast<char*>(&data_in[range.begin()]);
+        recv_nums_[src_fid] = range.size();
+        if (shm_.IsLocal(src_fid)) {
+          shm_req = shm_.PostRecv(src_fid, vec.data(), vec.size());
+        } else {
+          IrecvBytes(vec.data(), vec.size(), comm_spec_.FragToWorker(src_fid),
+                     0, comm_, &req);
+        }
+      }
       recv_reqs_.push_back(req);
+      shm_recv_reqs_.push_back(shm_req);
       recv_from_.push_back(src_fid);
+      recv_done_.push_back(false);
     }
 
     remaining_reqs_ = fnum_ - 1;
@@ -162,19 +352,38 @@ class BatchShuffleMessageManager : public MessageManagerBase {
       fid_t dst_fid = (i + fid_) % fnum_;
       auto& id_vec = frag.MirrorVertices(dst_fid);
       auto& vec = shuffle_out_buffers_[dst_fid];
-      vec.clear();
-      vec.resize(id_vec.size() * sizeof(DATA_T));
-      DATA_T* buf = reinterpret_cast<DATA_T*>(vec.data());
-      size_t num = id_vec.size();
+      if (sync_mode_ == SyncMode::kDelta) {
+        encodeMirrors(id_vec, data_out, mirror_values_[dst_fid], vec,
+                      thread_num);
+      } else if (sync_mode_ == SyncMode::kLossy) {
+        size_t num = id_vec.size();
+        gather_buffer_.resize(num * sizeof(DATA_T));
+        DATA_T* buf = reinterpret_cast<DATA_T*>(gather_buffer_.data());
 #pragma omp parallel for num_threads(thread_num)
-      for (size_t k = 0; k < num; ++k) {
-        buf[k] = data_out[id_vec[k]];
+        for (size_t k = 0; k < num; ++k) {
+          buf[k] = data_out[id_vec[k]];
+        }
+        lossy_codec_t::Encode(buf, num, codec_, max_error_, vec, thread_num);
+      } else {
+        vec.clear();
+        vec.resize(id_vec.size() * sizeof(DATA_T));
+        DATA_T* buf = reinterpret_cast<DATA_T*>(vec.data());
+        size_t num = id_vec.size();
+#pragma omp parallel for num_threads(thread_num)
+        for (size_t k = 0; k < num; ++k) {
+          buf[k] = data_out[id_vec[k]];
+        }
       }
 
-      MPI_Request req;
-      MPI_Isend(vec.data(), vec.size(), MPI_CHAR,
-                comm_spec_.FragToWorker(dst_fid), 0, comm_, &req);
       msg_size_ += vec.size();
+      if (shm_.IsLocal(dst_fid)) {
+        shm_send_reqs_.push_back(
+            shm_.PostSend(dst_fid, vec.data(), vec.size()));
+        continue;
+      }
+      MPI_Request req;
+      IsendBytes(vec.data(), vec.size(), comm_spec_.FragToWorker(dst_fid), 0,
+                 comm_, &req);
       send_reqs_.push_back(req);
     }
   }
@@ -192,50 +401,7 @@ class BatchShuffleMessageManager : public MessageManagerBase {
   void SyncInnerVertices(const GRAPH_T& frag,
                          VertexArray<DATA_T, typename GRAPH_T::vid_t>& data,
                          int thread_num = std::thread::hardware_concurrency()) {
-    to_terminate_ = false;
-
-    if (!send_reqs_.empty()) {
-      MPI_Waitall(send_reqs_.size(), &send_reqs_[0], MPI_STATUSES_IGNORE);
-      send_reqs_.clear();
-    }
-
-    if (!recv_reqs_.empty()) {
-      MPI_Waitall(recv_reqs_.size(), &recv_reqs_[0], MPI_STATUSES_IGNORE);
-      recv_reqs_.clear();
-      recv_from_.clear();
-    }
-
-    for (fid_t i = 1; i < fnum_; ++i) {
-      fid_t src_fid = (fid_ + fnum_ - i) % fnum_;
-      auto range = frag.OuterVertices(src_fid);
-      MPI_Request req;
-      MPI_Irecv(&data[range.begin()], range.size() * sizeof(DATA_T), MPI_CHAR,
-                comm_spec_.FragToWorker(src_fid), 0, comm_, &req);
-      recv_reqs_.push_back(req);
-      recv_from_.push_back(src_fid);
-    }
-
-    remaining_reqs_ = fnum_ - 1;
-
-    for (fid_t i = 1; i < fnum_; ++i) {
-      fid_t dst_fid = (i + fid_) % fnum_;
-      auto& id_vec = frag.MirrorVertices(dst_fid);
-      auto& vec = shuffle_out_buffers_[dst_fid];
-      vec.clear();
-      vec.resize(id_vec.size() * sizeof(DATA_T));
-      DATA_T* buf = reinterpret_cast<DATA_T*>(vec.data());
-      size_t num = id_vec.size();
-#pragma omp parallel for num_threads(thread_num)
-      for (size_t k = 0; k < num; ++k) {
-        buf[k] = data[id_vec[k]];
-      }
-
-      MPI_Request req;
-      MPI_Isend(vec.data(), vec.size(), MPI_CHAR,
-                comm_spec_.FragToWorker(dst_fid), 0, comm_, &req);
-      msg_size_ += vec.size();
-      send_reqs_.push_back(req);
-    }
+    SyncInnerVertices<GRAPH_T, DATA_T>(frag, data, data, thread_num);
   }
 
   /**
@@ -244,9 +410,18 @@ class BatchShuffleMessageManager : public MessageManagerBase {
    */
   void UpdateOuterVertices() {
     MPI_Waitall(recv_reqs_.size(), &recv_reqs_[0], MPI_STATUSES_IGNORE);
+    ShmTransport::WaitAll(shm_recv_reqs_);
+    if (sync_mode_ != SyncMode::kRaw) {
+      for (size_t i = 0; i < recv_from_.size(); ++i) {
+        if (!recv_done_[i]) {
+          decodeOuterVertices(recv_from_[i]);
+        }
+      }
+    }
     remaining_reqs_ = 0;
     recv_reqs_.clear();
     recv_from_.clear();
+    recv_done_.clear();
   }
 
   /**
@@ -256,14 +431,19 @@ class BatchShuffleMessageManager : public MessageManagerBase {
    * @return Source fragment id.
    */
   fid_t UpdatePartialOuterVertices() {
-    int index;
+    int index = waitAnyRecv();
     fid_t ret;
-    MPI_Waitany(recv_reqs_.size(), &recv_reqs_[0], &index, MPI_STATUS_IGNORE);
     remaining_reqs_--;
     ret = recv_from_[index];
+    recv_done_[index] = true;
+    if (sync_mode_ != SyncMode::kRaw) {
+      decodeOuterVertices(ret);
+    }
     if (remaining_reqs_ == 0) {
       recv_reqs_.clear();
+      shm_recv_reqs_.clear();
       recv_from_.clear();
+      recv_done_.clear();
     }
     return ret;
   }
@@ -274,6 +454,150 @@ class BatchShuffleMessageManager : public MessageManagerBase {
   void ForceContinue() {}
 
  private:
+  // encodings of messages in the ongoing synchronization.
+  enum class SyncMode { kRaw, kDelta, kLossy };
+
+  // Marks the dense encoding in the header of a message in the delta mode,
+  // otherwise the header is the number of changed values.
+  static constexpr size_t kDenseMark = std::numeric_limits<size_t>::max();
+
+  // Encode the values of mirrors to a fragment in the delta mode, last holds
+  // the values shipped last time and is updated in place.
+  template <typename VID_T, typename DATA_T>
+  void encodeMirrors(const std::vector<Vertex<VID_T>>& id_vec,
+                     const VertexArray<DATA_T, VID_T>& data_out,
+                     std::vector<char>& last, std::vector<char>& out,
+                     int thread_num) {
+    size_t num = id_vec.size();
+    DATA_T* values = reinterpret_cast<DATA_T*>(last.data());
+    if (last.size() != num * sizeof(DATA_T)) {
+      last.resize(num * sizeof(DATA_T));
+      values = reinterpret_cast<DATA_T*>(last.data());
+#pragma omp parallel for num_threads(thread_num)
+      for (size_t k = 0; k < num; ++k) {
+        values[k] = data_out[id_vec[k]];
+      }
+      writeDense(last, out);
+      return;
+    }
+
+    size_t word_num = (num + 63) / 64;
+    bitmap_.resize(word_num);
+    changed_.resize(word_num + 1);
+#pragma omp parallel for num_threads(thread_num)
+    for (size_t w = 0; w < word_num; ++w) {
+      uint64_t word = 0;
+      size_t end = std::min(num, (w + 1) * 64);
+      for (size_t k = w * 64; k < end; ++k) {
+        const DATA_T& value = data_out[id_vec[k]];
+        if (memcmp(&value, &values[k], sizeof(DATA_T)) != 0) {
+          values[k] = value;
+          word |= (static_cast<uint64_t>(1) << (k & 63));
+        }
+      }
+      bitmap_[w] = word;
+      changed_[w] = __builtin_popcountll(word);
+    }
+    size_t changed_num = 0;
+    for (size_t w = 0; w < word_num; ++w) {
+      size_t cnt = changed_[w];
+      changed_[w] = changed_num;
+      changed_num += cnt;
+    }
+
+    size_t sparse_size =
+        word_num * sizeof(uint64_t) + changed_num * sizeof(DATA_T);
+    if (sparse_size >= last.size()) {
+      writeDense(last, out);
+      return;
+    }
+    out.clear();
+    out.resize(sizeof(size_t) + sparse_size);
+    memcpy(out.data(), &changed_num, sizeof(size_t));
+    char* ptr = out.data() + sizeof(size_t);
+    memcpy(ptr, bitmap_.data(), word_num * sizeof(uint64_t));
+    DATA_T* buf = reinterpret_cast<DATA_T*>(ptr + word_num * sizeof(uint64_t));
+#pragma omp parallel for num_threads(thread_num)
+    for (size_t w = 0; w < word_num; ++w) {
+      uint64_t word = bitmap_[w];
+      DATA_T* dst = buf + changed_[w];
+      while (word != 0) {
+        size_t k = w * 64 + __builtin_ctzll(word);
+        *(dst++) = values[k];
+        word &= (word - 1);
+      }
+    }
+  }
+
+  void writeDense(const std::vector<char>& values, std::vector<char>& out) {
+    size_t mark = kDenseMark;
+    out.clear();
+    out.resize(sizeof(size_t) + values.size());
+    memcpy(out.data(), &mark, sizeof(size_t));
+    memcpy(out.data() + sizeof(size_t), values.data(), values.size());
+  }
+
+  // Decode the message from a fragment into the designated vertex array. In
+  // the delta mode, the copy of outer vertices from the fragment is patched
+  // with the message, then copied to the array.
+  void decodeOuterVertices(fid_t src_fid) {
+    if (sync_mode_ == SyncMode::kLossy) {
+      lossy_decoder_(recv_buffers_[src_fid].data(), recv_nums_[src_fid],
+                     recv_targets_[src_fid]);
+      return;
+    }
+    auto& values = outer_values_[src_fid];
+    const char* ptr = recv_buffers_[src_fid].data();
+    size_t header;
+    memcpy(&header, ptr, sizeof(size_t));
+    ptr += sizeof(size_t);
+    if (header == kDenseMark) {
+      memcpy(values.data(), ptr, values.size());
+    } else {
+      size_t num = values.size() / elem_size_;
+      size_t word_num = (num + 63) / 64;
+      const uint64_t* words = reinterpret_cast<const uint64_t*>(ptr);
+      ptr += word_num * sizeof(uint64_t);
+      for (size_t w = 0; w < word_num; ++w) {
+        uint64_t word = words[w];
+        while (word != 0) {
+          size_t k = w * 64 + __builtin_ctzll(word);
+          memcpy(values.data() + k * elem_size_, ptr, elem_size_);
+          ptr += elem_size_;
+          word &= (word - 1);
+        }
+      }
+    }
+    if (!values.empty()) {
+      memcpy(recv_targets_[src_fid], values.data(), values.size());
+    }
+  }
+
+  // Wait until a message not decoded before is received, polling both MPI
+  // and the shared memory transport if it is enabled.
+  int waitAnyRecv() {
+    int index;
+    if (!shm_.Enabled()) {
+      MPI_Waitany(recv_reqs_.size(), &recv_reqs_[0], &index, MPI_STATUS_IGNORE);
+      return index;
+    }
+    while (true) {
+      for (size_t i = 0; i < shm_recv_reqs_.size(); ++i) {
+        if (shm_recv_reqs_[i] != nullptr && !recv_done_[i] &&
+            ShmTransport::Test(shm_recv_reqs_[i])) {
+          return static_cast<int>(i);
+        }
+      }
+      int flag;
+      MPI_Testany(recv_reqs_.size(), &recv_reqs_[0], &index, &flag,
+                  MPI_STATUS_IGNORE);
+      if (flag && index != MPI_UNDEFINED) {
+        return index;
+      }
+      std::this_thread::yield();
+    }
+  }
+
   void recvThreadRoutine() {
     std::vector<MPI_Request> recv_thread_reqs(fnum_);
     std::vector<size_t> numbers(fnum_);
@@ -302,14 +626,38 @@ class BatchShuffleMessageManager : public MessageManagerBase {
 
   std::vector<MPI_Request> recv_reqs_;
   std::vector<fid_t> recv_from_;
+  std::vector<bool> recv_done_;
   fid_t remaining_reqs_;
 
   std::vector<MPI_Request> send_reqs_;
 
+  // requests through the shared memory transport, a receive request is null
+  // if the message is received through MPI.
+  ShmTransport shm_;
+  std::vector<ShmTransport::Request> shm_recv_reqs_;
+  std::vector<ShmTransport::Request> shm_send_reqs_;
+
   size_t msg_size_;
   std::thread recv_thread_;
 
   bool to_terminate_;
+
+  bool delta_sync_;
+  LossyCodecType codec_;
+  double max_error_;
+  SyncMode sync_mode_;
+  size_t elem_size_;
+  void (*lossy_decoder_)(const char*, size_t, char*);
+  std::vector<char> gather_buffer_;
+  // values of mirrors shipped to each fragment last time.
+  std::vector<std::vector<char>> mirror_values_;
+  // received messages and values of outer vertices from each fragment.
+  std::vector<std::vector<char>> recv_buffers_;
+  std::vector<std::vector<char>> outer_values_;
+  std::vector<char*> recv_targets_;
+  std::vector<size_t> recv_nums_;
+  std::vector<uint64_t> bitmap_;
+  std::vector<size_t> changed_;
 };
 
 }  // namespace grape
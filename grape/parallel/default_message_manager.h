@@ -20,6 +20,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "grape/communication/shm_transport.h"
 #include "grape/communication/sync_comm.h"
 #include "grape/parallel/message_manager_base.h"
 #include "grape/serialization/in_archive.h"
@@ -34,8 +35,12 @@ namespace grape {
  * The send and recv methods are not thread-safe.
  */
 class DefaultMessageManager : public MessageManagerBase {
+  static constexpr int kUpTag = 1;
+  static constexpr int kCrossTag = 2;
+  static constexpr int kDownTag = 3;
+
  public:
-  DefaultMessageManager() : comm_(NULL_COMM) {}
+  DefaultMessageManager() : comm_(NULL_COMM), hierarchical_(false) {}
   ~DefaultMessageManager() override {
     if (ValidComm(comm_)) {
       MPI_Comm_free(&comm_);
@@ -53,12 +58,55 @@ class DefaultMessageManager : public MessageManagerBase {
     fnum_ = comm_spec_.fnum();
 
     lengths_out_.resize(fnum_);
-    lengths_in_.resize(fnum_ * fnum_);
+    lengths_in_.resize(fnum_);
 
     to_send_.resize(fnum_);
     to_recv_.resize(fnum_);
   }
 
+  /**
+   * @brief Exchange messages with co-located workers through shared memory,
+   * which is collective and expected after Init.
+   *
+   * @param ring_size Capacity in bytes of the ring from each co-located
+   * worker.
+   */
+  void EnableShmTransport(size_t ring_size = ShmTransport::kDefaultRingSize) {
+    shm_.Init(comm_spec_, ring_size);
+  }
+
+  /**
+   * @brief Route messages to other hosts through the host leaders, instead of
+   * sending them directly to the workers.
+   *
+   * A worker sends one block to each co-located worker, and the block to its
+   * leader carries all its messages to other hosts as well. Leaders combine
+   * the messages by destination hosts and exchange a block per pair of hosts,
+   * then scatter the messages received to co-located workers. So each round
+   * takes O(L^2 + H^2) messages instead of O(P^2) for H hosts of L workers.
+   * It suits large clusters sending small messages to most workers. Blocks
+   * between co-located workers go through the shared memory transport if it
+   * is enabled.
+   *
+   * It is expected after Init, and to be set on all the workers.
+   *
+   * @param enable
+   */
+  void EnableHierarchicalRouting(bool enable = true) {
+    hierarchical_ = enable;
+    host_workers_.clear();
+    for (fid_t i = 0; i < fnum_; ++i) {
+      int worker = comm_spec_.FragToWorker(i);
+      if (i != fid_ &&
+          comm_spec_.WorkerToHost(worker) == comm_spec_.host_id()) {
+        host_workers_.push_back(i);
+      }
+    }
+    up_blocks_.resize(fnum_);
+    down_blocks_.resize(fnum_);
+    host_blocks_.resize(comm_spec_.host_num());
+  }
+
   /**
    * @brief Inherit
    */
@@ -73,6 +121,7 @@ class DefaultMessageManager : public MessageManagerBase {
       MPI_Waitall(reqs_.size(), &reqs_[0], MPI_STATUSES_IGNORE);
       reqs_.clear();
     }
+    ShmTransport::WaitAll(shm_reqs_);
     for (auto& arc : to_send_) {
       arc.Clear();
     }
@@ -84,37 +133,14 @@ class DefaultMessageManager : public MessageManagerBase {
    * @brief Inherit
    */
   void FinishARound() override {
-    syncLengths();
     to_terminate_ = checkTermination();
     if (to_terminate_) {
       return;
     }
-
-    for (fid_t i = 1; i < fnum_; ++i) {
-      fid_t src_fid = (fid_ + i) % fnum_;
-      size_t length = lengths_in_[src_fid * fnum_ + fid_];
-      if (length == 0) {
-        continue;
-      }
-      auto& arc = to_recv_[src_fid];
-      arc.Clear();
-      arc.Allocate(length);
-      MPI_Request req;
-      MPI_Irecv(arc.GetBuffer(), length, MPI_CHAR,
-                comm_spec_.FragToWorker(src_fid), 0, comm_, &req);
-      reqs_.push_back(req);
-    }
-
-    for (fid_t i = 1; i < fnum_; ++i) {
-      fid_t dst_fid = (fid_ + fnum_ - i) % fnum_;
-      auto& arc = to_send_[dst_fid];
-      if (arc.Empty()) {
-        continue;
-      }
-      MPI_Request req;
-      MPI_Isend(arc.GetBuffer(), arc.GetSize(), MPI_CHAR,
-                comm_spec_.FragToWorker(dst_fid), 0, comm_, &req);
-      reqs_.push_back(req);
+    if (hierarchical_) {
+      routeHierarchically();
+    } else {
+      routeDirectly();
     }
     to_recv_[fid_].Clear();
     if (!to_send_[fid_].Empty()) {
@@ -135,6 +161,8 @@ class DefaultMessageManager : public MessageManagerBase {
       MPI_Waitall(reqs_.size(), &reqs_[0], MPI_STATUSES_IGNORE);
       reqs_.clear();
     }
+    ShmTransport::WaitAll(shm_reqs_);
+    shm_.Finalize();
 
     MPI_Comm_free(&comm_);
     comm_ = NULL_COMM;
@@ -303,26 +331,207 @@ class DefaultMessageManager : public MessageManagerBase {
   fid_t fid() const { return fid_; }
   fid_t fnum() const { return fnum_; }
 
- private:
+  // exchange lengths of messages with an all-to-all, each worker only gets
+  // the lengths sent to it, i.e., O(fnum) rather than O(fnum^2) metadata.
   void syncLengths() {
     for (fid_t i = 0; i < fnum_; ++i) {
-      sent_size_ += to_send_[i].GetSize();
       lengths_out_[i] = to_send_[i].GetSize();
     }
-    if (force_continue_) {
-      ++lengths_out_[fid_];
+    MPI_Alltoall(&lengths_out_[0], sizeof(size_t), MPI_CHAR, &lengths_in_[0],
+                 sizeof(size_t), MPI_CHAR, comm_);
+  }
+
+  // sends messages to the workers directly, with the lengths exchanged.
+  void routeDirectly() {
+    syncLengths();
+
+    for (fid_t i = 1; i < fnum_; ++i) {
+      fid_t src_fid = (fid_ + i) % fnum_;
+      size_t length = lengths_in_[src_fid];
+      if (length == 0) {
+        continue;
+      }
+      auto& arc = to_recv_[src_fid];
+      arc.Clear();
+      arc.Allocate(length);
+      if (shm_.IsLocal(src_fid)) {
+        shm_reqs_.push_back(shm_.PostRecv(src_fid, arc.GetBuffer(), length));
+        continue;
+      }
+      MPI_Request req;
+      IrecvBytes(arc.GetBuffer(), length, comm_spec_.FragToWorker(src_fid), 0,
+                 comm_, &req);
+      reqs_.push_back(req);
+    }
+
+    for (fid_t i = 1; i < fnum_; ++i) {
+      fid_t dst_fid = (fid_ + fnum_ - i) % fnum_;
+      auto& arc = to_send_[dst_fid];
+      if (arc.Empty()) {
+        continue;
+      }
+      if (shm_.IsLocal(dst_fid)) {
+        shm_reqs_.push_back(
+            shm_.PostSend(dst_fid, arc.GetBuffer(), arc.GetSize()));
+        continue;
+      }
+      MPI_Request req;
+      IsendBytes(arc.GetBuffer(), arc.GetSize(),
+                 comm_spec_.FragToWorker(dst_fid), 0, comm_, &req);
+      reqs_.push_back(req);
     }
-    MPI_Allgather(&lengths_out_[0], fnum_ * sizeof(size_t), MPI_CHAR,
-                  &lengths_in_[0], fnum_ * sizeof(size_t), MPI_CHAR, comm_);
   }
 
-  bool checkTermination() {
-    for (auto s : lengths_in_) {
-      if (s != 0) {
-        return false;
+  // appends a record of messages from src to dst to a block.
+  static void appendRecord(InArchive& block, fid_t src, fid_t dst,
+                           const char* buf, size_t size) {
+    block << src << dst << size;
+    block.AddBytes(buf, size);
+  }
+
+  // func(src, dst, buf, size) is invoked on each record of a block.
+  template <typename FUNC_T>
+  static void parseBlock(OutArchive& block, const FUNC_T& func) {
+    while (!block.Empty()) {
+      fid_t src, dst;
+      size_t size;
+      block >> src >> dst >> size;
+      func(src, dst, static_cast<char*>(block.GetBytes(size)), size);
+    }
+  }
+
+  void receiveRecord(fid_t src, const char* buf, size_t size) {
+    auto& arc = to_recv_[src];
+    arc.Allocate(size);
+    memcpy(arc.GetBuffer(), buf, size);
+  }
+
+  void sendBlock(fid_t dst, const InArchive& block, int tag) {
+    if (shm_.IsLocal(dst)) {
+      shm_reqs_.push_back(
+          shm_.PostSend(dst, block.GetBuffer(), block.GetSize(), tag));
+      return;
+    }
+    MPI_Request req;
+    IsendBytes(block.GetBuffer(), block.GetSize(),
+               comm_spec_.FragToWorker(dst), tag, comm_, &req);
+    reqs_.push_back(req);
+  }
+
+  void recvBlock(fid_t src, OutArchive& block, int tag) {
+    if (shm_.IsLocal(src)) {
+      auto req = shm_.PostRecv(src);
+      ShmTransport::Wait(req);
+      block = std::move(ShmTransport::Payload(req));
+      return;
+    }
+    int worker = comm_spec_.FragToWorker(src);
+    MPI_Status status;
+    MPI_Probe(worker, tag, comm_, &status);
+    size_t count = GetBytesCount(status);
+    block.Clear();
+    block.Allocate(count);
+    RecvBytes(block.GetBuffer(), count, worker, tag, comm_);
+  }
+
+  // see EnableHierarchicalRouting, blocks are sent to all the co-located
+  // workers and other leaders even if they are empty, so the receivers know
+  // the number of blocks to receive. Blocks of a round are received before
+  // the round finishes, and sends are completed in the next StartARound.
+  void routeHierarchically() {
+    int host_id = comm_spec_.host_id();
+    fid_t leader = comm_spec_.WorkerToFrag(comm_spec_.HostLeader(host_id));
+    bool is_leader = (leader == fid_);
+    for (fid_t i = 0; i < fnum_; ++i) {
+      if (i != fid_) {
+        to_recv_[i].Clear();
       }
     }
-    return true;
+    for (auto& block : host_blocks_) {
+      block.Clear();
+    }
+    auto host_of = [this](fid_t fid) {
+      return comm_spec_.WorkerToHost(comm_spec_.FragToWorker(fid));
+    };
+
+    for (fid_t dst : host_workers_) {
+      up_blocks_[dst].Clear();
+    }
+    for (fid_t dst = 0; dst < fnum_; ++dst) {
+      auto& arc = to_send_[dst];
+      if (dst == fid_ || arc.Empty()) {
+        continue;
+      }
+      int dst_host = host_of(dst);
+      if (dst_host == host_id) {
+        appendRecord(up_blocks_[dst], fid_, dst, arc.GetBuffer(),
+                     arc.GetSize());
+      } else if (is_leader) {
+        appendRecord(host_blocks_[dst_host], fid_, dst, arc.GetBuffer(),
+                     arc.GetSize());
+      } else {
+        appendRecord(up_blocks_[leader], fid_, dst, arc.GetBuffer(),
+                     arc.GetSize());
+      }
+    }
+    for (fid_t dst : host_workers_) {
+      sendBlock(dst, up_blocks_[dst], kUpTag);
+    }
+
+    OutArchive block;
+    for (fid_t src : host_workers_) {
+      recvBlock(src, block, kUpTag);
+      parseBlock(block, [&](fid_t from, fid_t to, char* buf, size_t size) {
+        if (to == fid_) {
+          receiveRecord(from, buf, size);
+        } else {
+          appendRecord(host_blocks_[host_of(to)], from, to, buf, size);
+        }
+      });
+    }
+    if (!is_leader) {
+      recvBlock(leader, block, kDownTag);
+      parseBlock(block, [&](fid_t from, fid_t, char* buf, size_t size) {
+        receiveRecord(from, buf, size);
+      });
+      return;
+    }
+
+    int host_num = comm_spec_.host_num();
+    for (int i = 1; i < host_num; ++i) {
+      int dst_host = (host_id + i) % host_num;
+      sendBlock(comm_spec_.WorkerToFrag(comm_spec_.HostLeader(dst_host)),
+                host_blocks_[dst_host], kCrossTag);
+    }
+    for (fid_t dst : host_workers_) {
+      down_blocks_[dst].Clear();
+    }
+    for (int i = 1; i < host_num; ++i) {
+      int src_host = (host_id + host_num - i) % host_num;
+      recvBlock(comm_spec_.WorkerToFrag(comm_spec_.HostLeader(src_host)),
+                block, kCrossTag);
+      parseBlock(block, [&](fid_t from, fid_t to, char* buf, size_t size) {
+        if (to == fid_) {
+          receiveRecord(from, buf, size);
+        } else {
+          appendRecord(down_blocks_[to], from, to, buf, size);
+        }
+      });
+    }
+    for (fid_t dst : host_workers_) {
+      sendBlock(dst, down_blocks_[dst], kDownTag);
+    }
+  }
+
+  // terminate if no worker sent messages or forced to continue.
+  bool checkTermination() {
+    for (fid_t i = 0; i < fnum_; ++i) {
+      sent_size_ += to_send_[i].GetSize();
+    }
+    int flag = (sent_size_ != 0 || force_continue_) ? 1 : 0;
+    int ret;
+    MPI_Allreduce(&flag, &ret, 1, MPI_INT, MPI_SUM, comm_);
+    return (ret == 0);
   }
 
   std::vector<InArchive> to_send_;
@@ -335,6 +544,17 @@ class DefaultMessageManager : public MessageManagerBase {
   std::vector<MPI_Request> reqs_;
   MPI_Comm comm_;
 
+  ShmTransport shm_;
+  std::vector<ShmTransport::Request> shm_reqs_;
+
+  // states of the hierarchical routing, blocks to co-located workers and
+  // other hosts, which are kept until sent.
+  bool hierarchical_;
+  std::vector<fid_t> host_workers_;
+  std::vector<InArchive> up_blocks_;
+  std::vector<InArchive> down_blocks_;
+  std::vector<InArchive> host_blocks_;
+
   fid_t fid_;
   fid_t fnum_;
   CommSpec comm_spec_;
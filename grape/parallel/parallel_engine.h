@@ -16,20 +16,18 @@ limitations under the License.
 #ifndef GRAPE_PARALLEL_PARALLEL_ENGINE_H_
 #define GRAPE_PARALLEL_PARALLEL_ENGINE_H_
 
-#ifdef __LINUX__
-#ifndef _GNU_SOURCE
-#define _GNU_SOURCE
-#endif
-#include <sched.h>
-#endif
-
 #include <algorithm>
 #include <atomic>
 #include <memory>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include "grape/communication/sync_comm.h"
+#include "grape/utils/combiners.h"
+#include "grape/utils/concurrent_queue.h"
+#include "grape/utils/cpu_topology.h"
+#include "grape/utils/thread_pool.h"
 #include "grape/utils/vertex_set.h"
 #include "grape/worker/comm_spec.h"
 
@@ -37,8 +35,15 @@ namespace grape {
 
 struct ParallelEngineSpec {
   uint32_t thread_num;
+  // Whether to bind the i-th thread to cpu_list[i], if cpu_list is empty,
+  // threads are spread over physical cores before sharing them.
   bool affinity;
   std::vector<uint32_t> cpu_list;
+  // Whether to bind threads to NUMA nodes and schedule vertices node-locally.
+  bool numa;
+  // Cpus reserved for communication threads, e.g., send/recv threads in
+  // ParallelMessageManager and BasicFragmentLoader.
+  std::vector<uint32_t> comm_cpu_list;
 };
 
 ParallelEngineSpec DefaultParallelEngineSpec() {
@@ -46,40 +51,84 @@ ParallelEngineSpec DefaultParallelEngineSpec() {
   spec.thread_num = std::thread::hardware_concurrency();
   spec.affinity = false;
   spec.cpu_list.clear();
+  spec.numa = false;
+  spec.comm_cpu_list.clear();
   return spec;
 }
 
+/**
+ * @brief Spec for multiple processes on a host, each of them takes a share of
+ * the cpus.
+ *
+ * With affinity or numa, physical cores of the host are split into
+ * consecutive slices, ordered by NUMA nodes, one slice for each process. The
+ * first comm_core_num cores of a slice are reserved for communication
+ * threads, and compute threads are bound to the rest, avoiding hyperthreads
+ * of the same core as far as possible.
+ */
 ParallelEngineSpec MultiProcessSpec(const CommSpec& comm_spec,
-                                    bool affinity = false) {
+                                    bool affinity = false, bool numa = false,
+                                    uint32_t comm_core_num = 0) {
   ParallelEngineSpec spec;
   uint32_t total_thread_num = std::thread::hardware_concurrency();
   uint32_t each_process_thread_num =
       (total_thread_num + comm_spec.local_num() - 1) / comm_spec.local_num();
   spec.thread_num = each_process_thread_num;
-  spec.affinity = affinity;
+  spec.affinity = affinity || numa;
   spec.cpu_list.clear();
-  if (affinity) {
-    uint32_t offset = each_process_thread_num * comm_spec.local_id();
-    for (uint32_t i = 0; i < each_process_thread_num; ++i) {
-      spec.cpu_list.push_back((offset + i) % total_thread_num);
+  spec.numa = numa;
+  spec.comm_cpu_list.clear();
+  if (spec.affinity) {
+    CpuTopology topology;
+    size_t core_num = topology.core_num();
+    size_t core_begin = core_num * comm_spec.local_id() / comm_spec.local_num();
+    size_t core_end =
+        core_num * (comm_spec.local_id() + 1) / comm_spec.local_num();
+    if (core_begin == core_end) {
+      // more processes than cores.
+      core_begin = comm_spec.local_id() % core_num;
+      core_end = core_begin + 1;
     }
+    // leave at least one core for computation.
+    size_t reserved =
+        std::min(static_cast<size_t>(comm_core_num), core_end - core_begin - 1);
+    spec.comm_cpu_list =
+        topology.CoreSpreadCpus(core_begin, core_begin + reserved);
+    spec.cpu_list = topology.CoreSpreadCpus(core_begin + reserved, core_end);
+    spec.thread_num = spec.cpu_list.size();
   }
   return spec;
 }
 
 class ParallelEngine {
+  // Number of chunks per thread in the edge balanced ForEach, the more chunks
+  // the finer load balancing, at the cost of more stealing.
+  static constexpr size_t kChunksPerThread = 16;
+  // Adjacent lists longer than this are split into pieces of this length and
+  // scanned by multiple threads in ForEachEdge.
+  static constexpr size_t kHubDegreeThreshold = 4096;
+  // In NUMA mode, vertices are dealt to NUMA nodes in blocks of this size
+  // cyclically, i.e., block b is processed and placed on node b % node_num.
+  static constexpr size_t kNumaBlockSize = 64 * 1024;
+
  public:
-  ParallelEngine() : affinity_(false), thread_num_(1) {}
+  ParallelEngine()
+      : affinity_(false),
+        thread_num_(1),
+        numa_node_num_(1),
+        node_thread_offsets_({0, 1}),
+        thread_node_(1, 0) {}
   virtual ~ParallelEngine() {}
 
   void InitParallelEngine(
       const ParallelEngineSpec& spec = DefaultParallelEngineSpec()) {
-    affinity_ = false;
-#ifdef __LINUX__
-    affinity_ = spec.affinity && (!spec.cpu_list.empty());
-#endif
     thread_num_ = spec.thread_num;
-    if (affinity_) {
+    cpu_list_ = spec.cpu_list;
+    if ((spec.affinity || spec.numa) && cpu_list_.empty()) {
+      CpuTopology topology;
+      cpu_list_ = topology.CoreSpreadCpus(0, topology.core_num());
+    }
+    if (!cpu_list_.empty()) {
       if (cpu_list_.size() >= thread_num_) {
         cpu_list_.resize(thread_num_);
       } else {
@@ -89,6 +138,16 @@ class ParallelEngine {
         }
       }
     }
+    affinity_ = false;
+#ifdef __linux__
+    affinity_ = (spec.affinity || spec.numa) && (!cpu_list_.empty());
+#endif
+    initNuma(spec);
+    if (affinity_) {
+      thread_pool_.Start(thread_num_, cpu_list_);
+    } else {
+      thread_pool_.Start(thread_num_);
+    }
   }
 
   /**
@@ -104,32 +163,25 @@ class ParallelEngine {
   template <typename ITER_FUNC_T, typename T>
   inline void ForEach(const T* begin, const T* end,
                       const ITER_FUNC_T& iter_func) {
-    std::vector<std::thread> threads(thread_num_);
-
     size_t chunk_size = (end - begin) / thread_num_ + 1;
-    for (uint32_t i = 0; i < thread_num_; ++i) {
-      threads[i] = std::thread(
-          [chunk_size, &iter_func, begin, end](uint32_t tid) {
-            const T* cur_beg = std::min(begin + tid * chunk_size, end);
-            const T* cur_end = std::min(begin + (tid + 1) * chunk_size, end);
-            if (cur_beg != cur_end) {
-              for (auto iter = cur_beg; iter != cur_end; ++iter) {
-                iter_func(tid, iter);
-              }
-            }
-          },
-          i);
-      setThreadAffinity(threads[i], i);
-    }
-
-    for (uint32_t i = 0; i < thread_num_; ++i) {
-      threads[i].join();
-    }
+    runTask([chunk_size, &iter_func, begin, end](uint32_t tid) {
+      const T* cur_beg = std::min(begin + tid * chunk_size, end);
+      const T* cur_end = std::min(begin + (tid + 1) * chunk_size, end);
+      if (cur_beg != cur_end) {
+        for (auto iter = cur_beg; iter != cur_end; ++iter) {
+          iter_func(tid, iter);
+        }
+      }
+    });
   }
 
   /**
    * @brief Iterate on vertexs of a VertexRange concurrently.
    *
+   * Threads of the engine are shared by all the parallel primitives, so
+   * ForEach and the others must not be nested, e.g., invoked in iter_func,
+   * nor called concurrently from multiple threads.
+   *
    * @tparam ITER_FUNC_T Type of vertex program.
    * @tparam VID_T Type of vertex id.
    * @param range The vertex range to be iterated.
@@ -140,32 +192,28 @@ class ParallelEngine {
   template <typename ITER_FUNC_T, typename VID_T>
   inline void ForEach(const VertexRange<VID_T>& range,
                       const ITER_FUNC_T& iter_func, int chunk_size = 1024) {
-    std::vector<std::thread> threads(thread_num_);
+    if (numa_node_num_ > 1) {
+      forEachNuma(
+          range, [](uint32_t tid) {}, iter_func, [](uint32_t tid) {},
+          chunk_size);
+      return;
+    }
     std::atomic<VID_T> cur(range.begin().GetValue());
     VID_T end = range.end().GetValue();
 
-    for (uint32_t i = 0; i < thread_num_; ++i) {
-      threads[i] = std::thread(
-          [&cur, chunk_size, &iter_func, end](uint32_t tid) {
-            while (true) {
-              VID_T cur_beg = std::min(cur.fetch_add(chunk_size), end);
-              VID_T cur_end = std::min(cur_beg + chunk_size, end);
-              if (cur_beg == cur_end) {
-                break;
-              }
-              VertexRange<VID_T> cur_range(cur_beg, cur_end);
-              for (auto u : cur_range) {
-                iter_func(tid, u);
-              }
-            }
-          },
-          i);
-      setThreadAffinity(threads[i], i);
-    }
-
-    for (auto& thrd : threads) {
-      thrd.join();
-    }
+    runTask([&cur, chunk_size, &iter_func, end](uint32_t tid) {
+      while (true) {
+        VID_T cur_beg = std::min(cur.fetch_add(chunk_size), end);
+        VID_T cur_end = std::min(cur_beg + chunk_size, end);
+        if (cur_beg == cur_end) {
+          break;
+        }
+        VertexRange<VID_T> cur_range(cur_beg, cur_end);
+        for (auto u : cur_range) {
+          iter_func(tid, u);
+        }
+      }
+    });
   }
 
   /**
@@ -192,37 +240,197 @@ class ParallelEngine {
                       const ITER_FUNC_T& iter_func,
                       const FINALIZE_FUNC_T& finalize_func,
                       int chunk_size = 1024) {
-    std::vector<std::thread> threads(thread_num_);
+    if (numa_node_num_ > 1) {
+      forEachNuma(range, init_func, iter_func, finalize_func, chunk_size);
+      return;
+    }
     std::atomic<VID_T> cur(range.begin().GetValue());
     VID_T end = range.end().GetValue();
 
-    for (uint32_t i = 0; i < thread_num_; ++i) {
-      threads[i] = std::thread(
-          [&cur, chunk_size, &init_func, &iter_func, &finalize_func,
-           end](uint32_t tid) {
-            init_func(tid);
-
-            while (true) {
-              VID_T cur_beg = std::min(cur.fetch_add(chunk_size), end);
-              VID_T cur_end = std::min(cur_beg + chunk_size, end);
-              if (cur_beg == cur_end) {
-                break;
-              }
-              VertexRange<VID_T> cur_range(cur_beg, cur_end);
-              for (auto u : cur_range) {
-                iter_func(tid, u);
-              }
-            }
+    runTask([&cur, chunk_size, &init_func, &iter_func, &finalize_func,
+             end](uint32_t tid) {
+      init_func(tid);
 
-            finalize_func(tid);
-          },
-          i);
-      setThreadAffinity(threads[i], i);
-    }
+      while (true) {
+        VID_T cur_beg = std::min(cur.fetch_add(chunk_size), end);
+        VID_T cur_end = std::min(cur_beg + chunk_size, end);
+        if (cur_beg == cur_end) {
+          break;
+        }
+        VertexRange<VID_T> cur_range(cur_beg, cur_end);
+        for (auto u : cur_range) {
+          iter_func(tid, u);
+        }
+      }
+
+      finalize_func(tid);
+    });
+  }
+
+  /**
+   * @brief Iterate on vertexs of a VertexRange concurrently, with the range
+   * split by the number of edges instead of the number of vertices.
+   *
+   * The range is cut into chunks carrying similar number of edges, the chunks
+   * are dealt to threads in consecutive blocks, and a thread runs out of its
+   * own chunks steals from the others, from threads on the same NUMA node
+   * first. It is preferred to the vertex chunked
+   * ForEach on skewed graphs, where a chunk holding hubs may be much heavier
+   * than the others.
+   *
+   * @tparam ITER_FUNC_T Type of vertex program.
+   * @tparam VID_T Type of vertex id.
+   * @tparam NBR_T Type of neighbor.
+   * @param range The vertex range to be iterated.
+   * @param offsets CSR offsets of the adjacent lists to be balanced, edges of
+   * vertex v are [offsets[v], offsets[v + 1]), e.g.,
+   * frag.GetOutgoingOffsets().
+   * @param iter_func Vertex program to be applied on each vertex.
+   */
+  template <typename ITER_FUNC_T, typename VID_T, typename NBR_T>
+  inline void ForEachEdgeBalanced(const VertexRange<VID_T>& range,
+                                  const NBR_T* const* offsets,
+                                  const ITER_FUNC_T& iter_func) {
+    ForEachEdgeBalanced(
+        range, offsets, [](uint32_t tid) {}, iter_func, [](uint32_t tid) {});
+  }
 
-    for (auto& thrd : threads) {
-      thrd.join();
+  /**
+   * @brief Iterate on vertexs of a VertexRange concurrently with the range
+   * split by the number of edges, initialize function and finalize function
+   * can be provided to each thread.
+   *
+   * @tparam INIT_FUNC_T Type of thread init program.
+   * @tparam ITER_FUNC_T Type of vertex program.
+   * @tparam FINALIZE_FUNC_T Type of thread finalize program.
+   * @tparam VID_T Type of vertex id.
+   * @tparam NBR_T Type of neighbor.
+   * @param range The vertex range to be iterated.
+   * @param offsets CSR offsets of the adjacent lists to be balanced.
+   * @param init_func Initializing function to be invoked by each thread before
+   * iterating on vertexs.
+   * @param iter_func Vertex program to be applied on each vertex.
+   * @param finalize_func Finalizing function to be invoked by each thread after
+   * iterating on vertexs.
+   */
+  template <typename INIT_FUNC_T, typename ITER_FUNC_T,
+            typename FINALIZE_FUNC_T, typename VID_T, typename NBR_T>
+  inline void ForEachEdgeBalanced(const VertexRange<VID_T>& range,
+                                  const NBR_T* const* offsets,
+                                  const INIT_FUNC_T& init_func,
+                                  const ITER_FUNC_T& iter_func,
+                                  const FINALIZE_FUNC_T& finalize_func) {
+    std::vector<VID_T> bounds;
+    splitByEdges(range, offsets, bounds);
+    uint32_t chunk_num = bounds.size() - 1;
+    uint32_t thread_num = thread_num_;
+    std::vector<StealableRange> chunks(thread_num);
+    for (uint32_t i = 0; i < thread_num; ++i) {
+      chunks[i].Init(static_cast<uint64_t>(chunk_num) * i / thread_num,
+                     static_cast<uint64_t>(chunk_num) * (i + 1) / thread_num);
     }
+
+    runTask([this, &init_func, &iter_func, &finalize_func, &bounds, &chunks,
+             thread_num](uint32_t tid) {
+      init_func(tid);
+
+      uint32_t chunk_id;
+      for (uint32_t i = 0; i < thread_num; ++i) {
+        StealableRange& victim = chunks[stealVictim(tid, i)];
+        while (i == 0 ? victim.PopFront(chunk_id) : victim.PopBack(chunk_id)) {
+          VertexRange<VID_T> cur_range(bounds[chunk_id], bounds[chunk_id + 1]);
+          for (auto u : cur_range) {
+            iter_func(tid, u);
+          }
+        }
+      }
+
+      finalize_func(tid);
+    });
+  }
+
+  /**
+   * @brief Reduce the adjacent edges of each vertex in a VertexRange
+   * concurrently, i.e., parallelize on edges instead of on vertices.
+   *
+   * For each vertex v, the values mapped from its neighbors are folded into
+   * an accumulator starting from identity with combiner, and then apply_func
+   * is invoked with the result exactly once. Adjacent lists longer than
+   * hub_degree are split into pieces of hub_degree edges, the pieces are
+   * scanned by all threads, and their partial results are combined in order,
+   * so a hub vertex doesn't serialize the whole loop. The result is
+   * deterministic regardless of the number of threads.
+   *
+   * @tparam VID_T Type of vertex id.
+   * @tparam T Type of the accumulator.
+   * @tparam ADJ_FUNC_T Type of function to get the adjacent list of a vertex.
+   * @tparam MAP_FUNC_T Type of function to map a neighbor to a value.
+   * @tparam COMBINER_T Type of combiner, e.g., SumCombiner, MinCombiner.
+   * @tparam APPLY_FUNC_T Type of function to consume the result.
+   * @param range The vertex range to be iterated.
+   * @param adj_func Function returns the adjacent list of a vertex, e.g.,
+   * frag.GetIncomingAdjList(v).
+   * @param identity Identity of combiner, e.g., 0 for sum.
+   * @param map_func Function maps a neighbor to a value, map_func(nbr).
+   * @param combiner Function combines a value into the accumulator,
+   * combiner(T& acc, const T& val).
+   * @param apply_func Function invoked on each vertex with the result,
+   * apply_func(tid, v, result).
+   * @param hub_degree Degree threshold of vertices to be split.
+   */
+  template <typename VID_T, typename T, typename ADJ_FUNC_T,
+            typename MAP_FUNC_T, typename COMBINER_T, typename APPLY_FUNC_T>
+  inline void ForEachEdge(const VertexRange<VID_T>& range,
+                          const ADJ_FUNC_T& adj_func, const T& identity,
+                          const MAP_FUNC_T& map_func,
+                          const COMBINER_T& combiner,
+                          const APPLY_FUNC_T& apply_func,
+                          size_t hub_degree = kHubDegreeThreshold) {
+    using vertex_t = Vertex<VID_T>;
+    std::vector<std::vector<vertex_t>> thread_hubs(thread_num_);
+
+    // vertices with low degree are finished in one pass, hubs are deferred.
+    ForEach(
+        range, [](uint32_t tid) {},
+        [&adj_func, &identity, &map_func, &combiner, &apply_func, &thread_hubs,
+         hub_degree](uint32_t tid, vertex_t v) {
+          reduceAdjList(tid, v, adj_func, identity, map_func, combiner,
+                        apply_func, hub_degree, thread_hubs[tid]);
+        },
+        [](uint32_t tid) {});
+    reduceHubs(thread_hubs, adj_func, identity, map_func, combiner, apply_func,
+               hub_degree);
+  }
+
+  /**
+   * @brief Reduce the adjacent edges of each vertex in a VertexRange
+   * concurrently as above, with vertices of low degree scheduled by the edge
+   * balanced ForEachEdgeBalanced instead of vertex chunks.
+   *
+   * @param offsets CSR offsets of the adjacent lists to be balanced, e.g.,
+   * frag.GetIncomingOffsets().
+   */
+  template <typename VID_T, typename NBR_T, typename T, typename ADJ_FUNC_T,
+            typename MAP_FUNC_T, typename COMBINER_T, typename APPLY_FUNC_T>
+  inline void ForEachEdge(const VertexRange<VID_T>& range,
+                          const NBR_T* const* offsets,
+                          const ADJ_FUNC_T& adj_func, const T& identity,
+                          const MAP_FUNC_T& map_func,
+                          const COMBINER_T& combiner,
+                          const APPLY_FUNC_T& apply_func,
+                          size_t hub_degree = kHubDegreeThreshold) {
+    using vertex_t = Vertex<VID_T>;
+    std::vector<std::vector<vertex_t>> thread_hubs(thread_num_);
+
+    ForEachEdgeBalanced(
+        range, offsets,
+        [&adj_func, &identity, &map_func, &combiner, &apply_func, &thread_hubs,
+         hub_degree](uint32_t tid, vertex_t v) {
+          reduceAdjList(tid, v, adj_func, identity, map_func, combiner,
+                        apply_func, hub_degree, thread_hubs[tid]);
+        });
+    reduceHubs(thread_hubs, adj_func, identity, map_func, combiner, apply_func,
+               hub_degree);
   }
 
   /**
@@ -238,7 +446,6 @@ class ParallelEngine {
   template <typename ITER_FUNC_T, typename VID_T>
   inline void ForEach(const DenseVertexSet<VID_T>& dense_set,
                       const ITER_FUNC_T& iter_func, int chunk_size = 1024) {
-    std::vector<std::thread> threads(thread_num_);
     VertexRange<VID_T> range = dense_set.Range();
     std::atomic<VID_T> cur(range.begin().GetValue());
     VID_T beg = range.begin().GetValue();
@@ -247,42 +454,31 @@ class ParallelEngine {
     const Bitset& bs = dense_set.GetBitset();
     chunk_size = ((chunk_size + 63) / 64) * 64;
 
-    for (uint32_t i = 0; i < thread_num_; ++i) {
-      threads[i] = std::thread(
-          [&iter_func, &cur, chunk_size, &bs, beg, end](uint32_t tid) {
-            while (true) {
-              VID_T cur_beg = std::min(cur.fetch_add(chunk_size), end);
-              VID_T cur_end = std::min(cur_beg + chunk_size, end);
-              if (cur_beg == cur_end) {
-                break;
-              }
-              for (VID_T vid = cur_beg; vid < cur_end; vid += 64) {
-                Vertex<VID_T> v(vid);
-                uint64_t word = bs.get_word(vid - beg);
-                while (word != 0) {
-                  if (word & 1) {
-                    iter_func(tid, v);
-                  }
-                  ++v;
-                  word = word >> 1;
-                }
-              }
+    runTask([&iter_func, &cur, chunk_size, &bs, beg, end](uint32_t tid) {
+      while (true) {
+        VID_T cur_beg = std::min(cur.fetch_add(chunk_size), end);
+        VID_T cur_end = std::min(cur_beg + chunk_size, end);
+        if (cur_beg == cur_end) {
+          break;
+        }
+        for (VID_T vid = cur_beg; vid < cur_end; vid += 64) {
+          Vertex<VID_T> v(vid);
+          uint64_t word = bs.get_word(vid - beg);
+          while (word != 0) {
+            if (word & 1) {
+              iter_func(tid, v);
             }
-          },
-          i);
-      setThreadAffinity(threads[i], i);
-    }
-
-    for (auto& thrd : threads) {
-      thrd.join();
-    }
+            ++v;
+            word = word >> 1;
+          }
+        }
+      }
+    });
   }
 
   template <typename ITER_FUNC_T, typename VID_T>
   inline void ForEach(const Bitset& bitset, const VertexRange<VID_T>& range,
                       const ITER_FUNC_T& iter_func, int chunk_size = 1024) {
-    std::vector<std::thread> threads(thread_num_);
-
     VID_T origin_begin = range.begin().GetValue();
     VID_T origin_end = range.end().GetValue();
 
@@ -303,57 +499,49 @@ class ParallelEngine {
 
     std::atomic<VID_T> cur(batch_begin);
 
-    for (uint32_t i = 0; i < thread_num_; ++i) {
-      threads[i] = std::thread(
-          [&iter_func, &cur, chunk_size, &bitset, batch_begin, batch_end,
-           origin_begin, origin_end, this](uint32_t tid) {
-            if (tid == 0 && origin_begin < batch_begin) {
-              Vertex<VID_T> v(origin_begin);
-              Vertex<VID_T> end(batch_begin);
-              while (v != end) {
-                if (bitset.get_bit(v.GetValue())) {
-                  iter_func(tid, v);
-                }
-                ++v;
-              }
-            }
-            if (tid == (thread_num_ - 1) && batch_end < origin_end) {
-              Vertex<VID_T> v(batch_end);
-              Vertex<VID_T> end(origin_end);
-              while (v != end) {
-                if (bitset.get_bit(v.GetValue())) {
-                  iter_func(tid, v);
-                }
-                ++v;
-              }
-            }
-            if (batch_begin < batch_end) {
-              while (true) {
-                VID_T cur_beg = std::min(cur.fetch_add(chunk_size), batch_end);
-                VID_T cur_end = std::min(cur_beg + chunk_size, batch_end);
-                if (cur_beg == cur_end) {
-                  break;
-                }
-                for (VID_T vid = cur_beg; vid < cur_end; vid += 64) {
-                  Vertex<VID_T> v(vid);
-                  uint64_t word = bitset.get_word(vid);
-                  while (word != 0) {
-                    if (word & 1) {
-                      iter_func(tid, v);
-                    }
-                    ++v;
-                    word = word >> 1;
-                  }
-                }
+    runTask([&iter_func, &cur, chunk_size, &bitset, batch_begin, batch_end,
+             origin_begin, origin_end, this](uint32_t tid) {
+      if (tid == 0 && origin_begin < batch_begin) {
+        Vertex<VID_T> v(origin_begin);
+        Vertex<VID_T> end(batch_begin);
+        while (v != end) {
+          if (bitset.get_bit(v.GetValue())) {
+            iter_func(tid, v);
+          }
+          ++v;
+        }
+      }
+      if (tid == (thread_num_ - 1) && batch_end < origin_end) {
+        Vertex<VID_T> v(batch_end);
+        Vertex<VID_T> end(origin_end);
+        while (v != end) {
+          if (bitset.get_bit(v.GetValue())) {
+            iter_func(tid, v);
+          }
+          ++v;
+        }
+      }
+      if (batch_begin < batch_end) {
+        while (true) {
+          VID_T cur_beg = std::min(cur.fetch_add(chunk_size), batch_end);
+          VID_T cur_end = std::min(cur_beg + chunk_size, batch_end);
+          if (cur_beg == cur_end) {
+            break;
+          }
+          for (VID_T vid = cur_beg; vid < cur_end; vid += 64) {
+            Vertex<VID_T> v(vid);
+            uint64_t word = bitset.get_word(vid);
+            while (word != 0) {
+              if (word & 1) {
+                iter_func(tid, v);
               }
+              ++v;
+              word = word >> 1;
             }
-          },
-          i);
-      setThreadAffinity(threads[i], i);
-    }
-    for (auto& thrd : threads) {
-      thrd.join();
-    }
+          }
+        }
+      }
+    });
   }
 
   /**
@@ -380,7 +568,6 @@ class ParallelEngine {
                       const ITER_FUNC_T& iter_func,
                       const FINALIZE_FUNC_T& finalize_func,
                       int chunk_size = 10 * 1024) {
-    std::vector<std::thread> threads(thread_num_);
     VertexRange<VID_T> range = dense_set.Range();
     std::atomic<VID_T> cur(range.begin().GetValue());
     VID_T beg = range.begin().GetValue();
@@ -389,59 +576,780 @@ class ParallelEngine {
     const Bitset& bs = dense_set.GetBitset();
     chunk_size = ((chunk_size + 63) / 64) * 64;
 
-    for (uint32_t i = 0; i < thread_num_; ++i) {
-      threads[i] = std::thread(
-          [&init_func, &finalize_func, &iter_func, &cur, chunk_size, &bs, beg,
-           end](uint32_t tid) {
-            init_func(tid);
-
-            while (true) {
-              VID_T cur_beg = std::min(cur.fetch_add(chunk_size), end);
-              VID_T cur_end = std::min(cur_beg + chunk_size, end);
-              if (cur_beg == cur_end) {
-                break;
-              }
-              for (VID_T vid = cur_beg; vid < cur_end; vid += 64) {
-                Vertex<VID_T> v(vid);
-                uint64_t word = bs.get_word(vid - beg);
-                while (word != 0) {
-                  if (word & 1) {
-                    iter_func(tid, v);
-                  }
-                  ++v;
-                  word = word >> 1;
-                }
-              }
+    runTask([&init_func, &finalize_func, &iter_func, &cur, chunk_size, &bs, beg,
+             end](uint32_t tid) {
+      init_func(tid);
+
+      while (true) {
+        VID_T cur_beg = std::min(cur.fetch_add(chunk_size), end);
+        VID_T cur_end = std::min(cur_beg + chunk_size, end);
+        if (cur_beg == cur_end) {
+          break;
+        }
+        for (VID_T vid = cur_beg; vid < cur_end; vid += 64) {
+          Vertex<VID_T> v(vid);
+          uint64_t word = bs.get_word(vid - beg);
+          while (word != 0) {
+            if (word & 1) {
+              iter_func(tid, v);
             }
+            ++v;
+            word = word >> 1;
+          }
+        }
+      }
 
-            finalize_func(tid);
-          },
-          i);
-      setThreadAffinity(threads[i], i);
+      finalize_func(tid);
+    });
+  }
+
+  /**
+   * @brief Iterate on vertices of a Frontier concurrently.
+   *
+   * A sparse frontier is iterated through its thread local lists, which costs
+   * O(active vertices), and a dense one through its bitmap.
+   *
+   * @tparam ITER_FUNC_T Type of vertex program.
+   * @tparam VID_T Type of vertex id.
+   * @param frontier The frontier to be iterated.
+   * @param iter_func Vertex program to be applied on each vertex.
+   * @param chunk_size Vertices granularity to be scheduled by threads.
+   */
+  template <typename ITER_FUNC_T, typename VID_T>
+  inline void ForEach(const Frontier<VID_T>& frontier,
+                      const ITER_FUNC_T& iter_func, int chunk_size = 1024) {
+    ForEach(frontier, frontier.Range(), iter_func, chunk_size);
+  }
+
+  /**
+   * @brief Iterate on vertices of a Frontier within a VertexRange
+   * concurrently, e.g., the inner vertices of a frontier on all vertices.
+   *
+   * @tparam ITER_FUNC_T Type of vertex program.
+   * @tparam VID_T Type of vertex id.
+   * @param frontier The frontier to be iterated.
+   * @param range Only vertices in this range are iterated.
+   * @param iter_func Vertex program to be applied on each vertex.
+   * @param chunk_size Vertices granularity to be scheduled by threads.
+   */
+  template <typename ITER_FUNC_T, typename VID_T>
+  inline void ForEach(const Frontier<VID_T>& frontier,
+                      const VertexRange<VID_T>& range,
+                      const ITER_FUNC_T& iter_func, int chunk_size = 1024) {
+    VID_T range_beg = std::max(range.begin().GetValue(),
+                               frontier.Range().begin().GetValue());
+    VID_T range_end = std::min(range.end().GetValue(),
+                               frontier.Range().end().GetValue());
+    if (range_beg >= range_end) {
+      return;
     }
 
-    for (auto& thrd : threads) {
-      thrd.join();
+    if (frontier.IsDense()) {
+      VID_T beg = frontier.Range().begin().GetValue();
+      const Bitset& bs = frontier.GetDenseSet().GetBitset();
+      size_t from = (range_beg - beg) / 64 * 64;
+      size_t to = range_end - beg;
+      size_t block_size = ((chunk_size + 63) / 64) * 64;
+      forEachBlock(to - from, block_size,
+                   [&bs, &iter_func, beg, from, range_beg, range_end](
+                       uint32_t tid, size_t block, size_t cur_from,
+                       size_t cur_to) {
+                     forEachBit(bs, beg, from + cur_from, from + cur_to,
+                                [tid, &iter_func, range_beg,
+                                 range_end](Vertex<VID_T> v) {
+                                  if (v.GetValue() >= range_beg &&
+                                      v.GetValue() < range_end) {
+                                    iter_func(tid, v);
+                                  }
+                                });
+                   });
+      return;
     }
+
+    // concatenate the thread local lists logically.
+    int list_num = frontier.ListNum();
+    std::vector<size_t> offsets(list_num + 1, 0);
+    for (int i = 0; i < list_num; ++i) {
+      offsets[i + 1] = offsets[i] + frontier.LocalVertices(i).size();
+    }
+    size_t total = offsets[list_num];
+    // sparse frontiers are small, split them finely for load balancing.
+    size_t block_size =
+        std::min(static_cast<size_t>(chunk_size), blockSize(total, 1));
+    forEachBlock(total, block_size,
+                 [&frontier, &offsets, &iter_func, range_beg, range_end](
+                     uint32_t tid, size_t block, size_t from, size_t to) {
+                   int list = std::upper_bound(offsets.begin(), offsets.end(),
+                                               from) -
+                              offsets.begin() - 1;
+                   while (from < to) {
+                     auto& vertices = frontier.LocalVertices(list);
+                     size_t list_end = std::min(to, offsets[list + 1]);
+                     for (size_t i = from; i < list_end; ++i) {
+                       Vertex<VID_T> v = vertices[i - offsets[list]];
+                       if (v.GetValue() >= range_beg &&
+                           v.GetValue() < range_end) {
+                         iter_func(tid, v);
+                       }
+                     }
+                     from = list_end;
+                     ++list;
+                   }
+                 });
+  }
+
+  /**
+   * @brief Reduce values mapped from vertices of a VertexRange concurrently.
+   *
+   * Each thread accumulates into a local value instead of a shared one, and
+   * partial results of blocks are combined in the order of vertices, so the
+   * result is deterministic for a given thread number, e.g., a sum of
+   * doubles.
+   *
+   * @tparam T Type of the reduced value.
+   * @tparam MAP_FUNC_T Type of map function.
+   * @tparam COMBINER_T Type of combiner, e.g., SumCombiner.
+   * @tparam VID_T Type of vertex id.
+   * @param range The vertex range to be reduced.
+   * @param identity Identity of the combiner.
+   * @param map_func Function mapping (tid, vertex) to a value of T.
+   * @param combiner Function combining the second value into the first one.
+   * @return The reduced value.
+   */
+  template <typename T, typename MAP_FUNC_T, typename COMBINER_T,
+            typename VID_T>
+  inline T ParallelReduce(const VertexRange<VID_T>& range, const T& identity,
+                          const MAP_FUNC_T& map_func,
+                          const COMBINER_T& combiner) {
+    VID_T beg = range.begin().GetValue();
+    return reduceBlocks(
+        range.size(), 1, identity,
+        [beg, &map_func, &combiner](uint32_t tid, size_t from, size_t to,
+                                    T& acc) {
+          VertexRange<VID_T> cur_range(beg + from, beg + to);
+          for (auto v : cur_range) {
+            combiner(acc, map_func(tid, v));
+          }
+        },
+        combiner);
+  }
+
+  /**
+   * @brief Reduce values mapped from vertices of a DenseVertexSet
+   * concurrently, see the VertexRange version.
+   */
+  template <typename T, typename MAP_FUNC_T, typename COMBINER_T,
+            typename VID_T>
+  inline T ParallelReduce(const DenseVertexSet<VID_T>& dense_set,
+                          const T& identity, const MAP_FUNC_T& map_func,
+                          const COMBINER_T& combiner) {
+    VertexRange<VID_T> range = dense_set.Range();
+    VID_T beg = range.begin().GetValue();
+    const Bitset& bs = dense_set.GetBitset();
+    return reduceBlocks(
+        range.size(), 64, identity,
+        [beg, &bs, &map_func, &combiner](uint32_t tid, size_t from, size_t to,
+                                         T& acc) {
+          forEachBit(bs, beg, from, to, [tid, &acc, &map_func, &combiner](
+                                            Vertex<VID_T> v) {
+            combiner(acc, map_func(tid, v));
+          });
+        },
+        combiner);
+  }
+
+  /**
+   * @brief Reduce values mapped from elements of an array concurrently, see
+   * the VertexRange version. map_func is invoked with (tid, iterator).
+   */
+  template <typename T, typename MAP_FUNC_T, typename COMBINER_T,
+            typename ELEM_T>
+  inline T ParallelReduce(const ELEM_T* begin, const ELEM_T* end,
+                          const T& identity, const MAP_FUNC_T& map_func,
+                          const COMBINER_T& combiner) {
+    return reduceBlocks(
+        end - begin, 1, identity,
+        [begin, &map_func, &combiner](uint32_t tid, size_t from, size_t to,
+                                      T& acc) {
+          for (const ELEM_T* iter = begin + from; iter != begin + to; ++iter) {
+            combiner(acc, map_func(tid, iter));
+          }
+        },
+        combiner);
+  }
+
+  /**
+   * @brief Compute the exclusive prefix sums of an array concurrently, i.e.,
+   * out[i] = begin[0] + ... + begin[i - 1].
+   *
+   * @tparam T Type of elements.
+   * @param begin Begin of the input array.
+   * @param end End of the input array.
+   * @param out Begin of the output array, it can be the same as begin.
+   * @return The sum of all elements.
+   */
+  template <typename T>
+  inline T ParallelPrefixSum(const T* begin, const T* end, T* out) {
+    return scanBlocks<T>(
+        end - begin,
+        [begin](uint32_t tid, size_t from, size_t to) {
+          T sum = T();
+          for (size_t i = from; i != to; ++i) {
+            sum += begin[i];
+          }
+          return sum;
+        },
+        [begin, out](uint32_t tid, size_t from, size_t to, T offset) {
+          for (size_t i = from; i != to; ++i) {
+            T val = begin[i];
+            out[i] = offset;
+            offset += val;
+          }
+        });
+  }
+
+  /**
+   * @brief Compute the exclusive prefix sums of values mapped from vertices
+   * of a VertexRange concurrently, e.g., offsets of per-vertex outputs.
+   *
+   * @tparam T Type of values.
+   * @tparam MAP_FUNC_T Type of map function.
+   * @tparam VID_T Type of vertex id.
+   * @param range The vertex range to be scanned.
+   * @param map_func Function mapping (tid, vertex) to a value of T, which is
+   * invoked exactly once on each vertex.
+   * @param out Output array, out[v] is the sum of values of vertices before v
+   * in range.
+   * @return The sum of all values.
+   */
+  template <typename T, typename MAP_FUNC_T, typename VID_T>
+  inline T ParallelPrefixSum(const VertexRange<VID_T>& range,
+                             const MAP_FUNC_T& map_func,
+                             VertexArray<T, VID_T>& out) {
+    VID_T beg = range.begin().GetValue();
+    return scanBlocks<T>(
+        range.size(),
+        [beg, &map_func, &out](uint32_t tid, size_t from, size_t to) {
+          T sum = T();
+          VertexRange<VID_T> cur_range(beg + from, beg + to);
+          for (auto v : cur_range) {
+            out[v] = map_func(tid, v);
+            sum += out[v];
+          }
+          return sum;
+        },
+        [beg, &out](uint32_t tid, size_t from, size_t to, T offset) {
+          VertexRange<VID_T> cur_range(beg + from, beg + to);
+          for (auto v : cur_range) {
+            T val = out[v];
+            out[v] = offset;
+            offset += val;
+          }
+        });
+  }
+
+  /**
+   * @brief Collect vertices of a VertexRange satisfying a predicate
+   * concurrently, the order of vertices is preserved in the output.
+   *
+   * @tparam PRED_FUNC_T Type of predicate.
+   * @tparam VID_T Type of vertex id.
+   * @param range The vertex range to be filtered.
+   * @param pred_func Predicate invoked with (tid, vertex).
+   * @param out Output vertices, the previous content is replaced.
+   */
+  template <typename PRED_FUNC_T, typename VID_T>
+  inline void ParallelFilter(const VertexRange<VID_T>& range,
+                             const PRED_FUNC_T& pred_func,
+                             std::vector<Vertex<VID_T>>& out) {
+    VID_T beg = range.begin().GetValue();
+    filterBlocks(
+        range.size(), 1,
+        [beg, &pred_func](uint32_t tid, size_t from, size_t to,
+                          std::vector<Vertex<VID_T>>& buf) {
+          VertexRange<VID_T> cur_range(beg + from, beg + to);
+          for (auto v : cur_range) {
+            if (pred_func(tid, v)) {
+              buf.push_back(v);
+            }
+          }
+        },
+        out);
+  }
+
+  /**
+   * @brief Collect vertices of a DenseVertexSet satisfying a predicate
+   * concurrently, see the VertexRange version.
+   */
+  template <typename PRED_FUNC_T, typename VID_T>
+  inline void ParallelFilter(const DenseVertexSet<VID_T>& dense_set,
+                             const PRED_FUNC_T& pred_func,
+                             std::vector<Vertex<VID_T>>& out) {
+    VertexRange<VID_T> range = dense_set.Range();
+    VID_T beg = range.begin().GetValue();
+    const Bitset& bs = dense_set.GetBitset();
+    filterBlocks(
+        range.size(), 64,
+        [beg, &bs, &pred_func](uint32_t tid, size_t from, size_t to,
+                               std::vector<Vertex<VID_T>>& buf) {
+          forEachBit(bs, beg, from, to,
+                     [tid, &buf, &pred_func](Vertex<VID_T> v) {
+                       if (pred_func(tid, v)) {
+                         buf.push_back(v);
+                       }
+                     });
+        },
+        out);
+  }
+
+  /**
+   * @brief Collect elements of an array satisfying a predicate concurrently,
+   * see the VertexRange version. pred_func is invoked with (tid, iterator).
+   */
+  template <typename PRED_FUNC_T, typename T>
+  inline void ParallelFilter(const T* begin, const T* end,
+                             const PRED_FUNC_T& pred_func,
+                             std::vector<T>& out) {
+    filterBlocks(
+        end - begin, 1,
+        [begin, &pred_func](uint32_t tid, size_t from, size_t to,
+                            std::vector<T>& buf) {
+          for (const T* iter = begin + from; iter != begin + to; ++iter) {
+            if (pred_func(tid, iter)) {
+              buf.push_back(*iter);
+            }
+          }
+        },
+        out);
+  }
+
+  /**
+   * @brief Move the memory of a VertexArray to NUMA nodes, each block of
+   * vertices is placed on the node whose threads process it in ForEach.
+   *
+   * Elements are copied into a new buffer by threads of the owning nodes, so
+   * the pages are first touched there. It does nothing if the engine is not
+   * in NUMA mode. Only arrays of trivial types are supported.
+   *
+   * @tparam T Type of elements.
+   * @tparam VID_T Type of vertex id.
+   * @param array The VertexArray to be placed.
+   */
+  template <typename T, typename VID_T>
+  void LocalizeVertexArray(VertexArray<T, VID_T>& array) {
+    if (numa_node_num_ <= 1) {
+      return;
+    }
+    VertexRange<VID_T> range = array.GetVertexRange();
+    VID_T begin = range.begin().GetValue(), end = range.end().GetValue();
+    if (begin == end) {
+      return;
+    }
+    VertexArray<T, VID_T> placed;
+    placed.InitUninitialized(range);
+    size_t first_block = begin / kNumaBlockSize;
+    size_t last_block = (end - 1) / kNumaBlockSize + 1;
+
+    runTask([this, &array, &placed, begin, end, first_block,
+             last_block](uint32_t tid) {
+      uint32_t node = thread_node_[tid];
+      uint32_t node_thread_begin = node_thread_offsets_[node];
+      uint32_t node_thread_num =
+          node_thread_offsets_[node + 1] - node_thread_begin;
+      // blocks of a node are dealt to its threads round-robin.
+      size_t k = 0;
+      for (size_t block = firstNumaBlock(first_block, node); block < last_block;
+           block += numa_node_num_, ++k) {
+        if (k % node_thread_num != tid - node_thread_begin) {
+          continue;
+        }
+        VID_T cur_beg = std::max(static_cast<size_t>(begin),
+                                 block * kNumaBlockSize);
+        VID_T cur_end = std::min(static_cast<size_t>(end),
+                                 (block + 1) * kNumaBlockSize);
+        VertexRange<VID_T> cur_range(cur_beg, cur_end);
+        for (auto v : cur_range) {
+          placed[v] = array[v];
+        }
+      }
+    });
+    array.Swap(placed);
   }
 
   uint32_t thread_num() { return thread_num_; }
 
  private:
-  inline void setThreadAffinity(std::thread& thrd, uint32_t i) {
-#ifdef __LINUX__
-    if (affinity_) {
-      cpu_set_t cpuset;
-      CPU_ZERO(&cpuset);
-      CPU_SET(cpu_list_[i], &cpuset);
-      pthread_setaffinity_np(thrd.native_handle(), sizeof(cpu_set_t), &cpuset);
+  /**
+   * @brief Group threads by NUMA nodes in NUMA mode, threads on the same node
+   * are given consecutive ids by reordering cpu_list_.
+   */
+  void initNuma(const ParallelEngineSpec& spec) {
+    numa_node_num_ = 1;
+    node_thread_offsets_ = {0, thread_num_};
+    thread_node_.assign(thread_num_, 0);
+    if (!spec.numa || cpu_list_.empty()) {
+      return;
     }
-#endif
+
+    CpuTopology topology;
+    std::vector<uint32_t>& cpus = cpu_list_;
+    std::stable_sort(cpus.begin(), cpus.end(),
+                     [&topology](uint32_t lhs, uint32_t rhs) {
+                       return topology.cpu_node(lhs) < topology.cpu_node(rhs);
+                     });
+
+    node_thread_offsets_.clear();
+    for (uint32_t i = 0; i < thread_num_; ++i) {
+      if (i == 0 || topology.cpu_node(cpus[i]) !=
+                        topology.cpu_node(cpus[i - 1])) {
+        node_thread_offsets_.push_back(i);
+      }
+      thread_node_[i] = node_thread_offsets_.size() - 1;
+    }
+    node_thread_offsets_.push_back(thread_num_);
+    numa_node_num_ = node_thread_offsets_.size() - 1;
+  }
+
+  // The first block in [first_block, ...) which belongs to node.
+  inline size_t firstNumaBlock(size_t first_block, uint32_t node) const {
+    return first_block +
+           (node + numa_node_num_ - first_block % numa_node_num_) %
+               numa_node_num_;
+  }
+
+  // The i-th thread for tid to take chunks from in work stealing, i = 0 is
+  // tid itself, and threads on the same NUMA node come before the others.
+  inline uint32_t stealVictim(uint32_t tid, uint32_t i) const {
+    uint32_t node = thread_node_[tid];
+    uint32_t node_thread_begin = node_thread_offsets_[node];
+    uint32_t node_thread_num =
+        node_thread_offsets_[node + 1] - node_thread_begin;
+    if (i < node_thread_num) {
+      return node_thread_begin +
+             (tid - node_thread_begin + i) % node_thread_num;
+    }
+    return (node_thread_begin + i) % thread_num_;
+  }
+
+  /**
+   * @brief ForEach on a VertexRange in NUMA mode, threads take chunks from
+   * blocks of their own node, and then from other nodes.
+   */
+  template <typename INIT_FUNC_T, typename ITER_FUNC_T,
+            typename FINALIZE_FUNC_T, typename VID_T>
+  void forEachNuma(const VertexRange<VID_T>& range,
+                   const INIT_FUNC_T& init_func, const ITER_FUNC_T& iter_func,
+                   const FINALIZE_FUNC_T& finalize_func, size_t chunk_size) {
+    VID_T begin = range.begin().GetValue(), end = range.end().GetValue();
+    size_t first_block = begin / kNumaBlockSize;
+    size_t last_block =
+        (begin == end) ? first_block : (end - 1) / kNumaBlockSize + 1;
+    size_t chunks_per_block = (kNumaBlockSize + chunk_size - 1) / chunk_size;
+    std::vector<std::atomic<size_t>> cursors(numa_node_num_);
+    for (auto& cursor : cursors) {
+      cursor.store(0);
+    }
+
+    runTask([this, &init_func, &iter_func, &finalize_func, &cursors, begin,
+             end, first_block, last_block, chunk_size,
+             chunks_per_block](uint32_t tid) {
+      init_func(tid);
+
+      uint32_t home = thread_node_[tid];
+      for (uint32_t i = 0; i < numa_node_num_; ++i) {
+        uint32_t node = (home + i) % numa_node_num_;
+        size_t node_first_block = firstNumaBlock(first_block, node);
+        while (true) {
+          size_t chunk = cursors[node].fetch_add(1);
+          size_t block =
+              node_first_block + chunk / chunks_per_block * numa_node_num_;
+          if (block >= last_block) {
+            break;
+          }
+          size_t block_end = (block + 1) * kNumaBlockSize;
+          size_t cur_beg =
+              block * kNumaBlockSize + chunk % chunks_per_block * chunk_size;
+          size_t cur_end = std::min(cur_beg + chunk_size, block_end);
+          cur_beg = std::max(cur_beg, static_cast<size_t>(begin));
+          cur_end = std::min(cur_end, static_cast<size_t>(end));
+          for (size_t v = cur_beg; v < cur_end; ++v) {
+            iter_func(tid, Vertex<VID_T>(v));
+          }
+        }
+      }
+
+      finalize_func(tid);
+    });
+  }
+
+  // reduces the adjacent list of v and applies the result, or defers v to
+  // hubs if its degree is larger than hub_degree.
+  template <typename VID_T, typename T, typename ADJ_FUNC_T,
+            typename MAP_FUNC_T, typename COMBINER_T, typename APPLY_FUNC_T>
+  static inline void reduceAdjList(uint32_t tid, Vertex<VID_T> v,
+                                   const ADJ_FUNC_T& adj_func,
+                                   const T& identity,
+                                   const MAP_FUNC_T& map_func,
+                                   const COMBINER_T& combiner,
+                                   const APPLY_FUNC_T& apply_func,
+                                   size_t hub_degree,
+                                   std::vector<Vertex<VID_T>>& hubs) {
+    auto es = adj_func(v);
+    if (es.Size() > hub_degree) {
+      hubs.push_back(v);
+      return;
+    }
+    T acc = identity;
+    for (auto& e : es) {
+      combiner(acc, map_func(e));
+    }
+    apply_func(tid, v, acc);
+  }
+
+  // splits the adjacent lists of hubs deferred by threads into pieces, which
+  // are scanned by all threads and combined per hub in order.
+  template <typename VID_T, typename T, typename ADJ_FUNC_T,
+            typename MAP_FUNC_T, typename COMBINER_T, typename APPLY_FUNC_T>
+  void reduceHubs(const std::vector<std::vector<Vertex<VID_T>>>& thread_hubs,
+                  const ADJ_FUNC_T& adj_func, const T& identity,
+                  const MAP_FUNC_T& map_func, const COMBINER_T& combiner,
+                  const APPLY_FUNC_T& apply_func, size_t hub_degree) {
+    using vertex_t = Vertex<VID_T>;
+    std::vector<vertex_t> hubs;
+    for (auto& vec : thread_hubs) {
+      hubs.insert(hubs.end(), vec.begin(), vec.end());
+    }
+    if (hubs.empty()) {
+      return;
+    }
+
+    // pieces of the i-th hub are [piece_offsets[i], piece_offsets[i + 1]).
+    std::vector<size_t> piece_offsets(hubs.size() + 1, 0);
+    std::vector<uint32_t> piece_owners;
+    for (size_t i = 0; i < hubs.size(); ++i) {
+      size_t degree = adj_func(hubs[i]).Size();
+      piece_offsets[i + 1] =
+          piece_offsets[i] + (degree + hub_degree - 1) / hub_degree;
+      piece_owners.resize(piece_offsets[i + 1], i);
+    }
+    size_t piece_num = piece_owners.size();
+    std::vector<T> partials(piece_num, identity);
+
+    std::atomic<size_t> cur(0);
+    runTask([&adj_func, &map_func, &combiner, &hubs, &piece_offsets,
+             &piece_owners, &partials, &cur, piece_num,
+             hub_degree](uint32_t tid) {
+      while (true) {
+        size_t piece = cur.fetch_add(1);
+        if (piece >= piece_num) {
+          break;
+        }
+        uint32_t owner = piece_owners[piece];
+        auto es = adj_func(hubs[owner]);
+        auto begin = es.begin_pointer() +
+                     (piece - piece_offsets[owner]) * hub_degree;
+        auto end = std::min(begin + hub_degree, es.end_pointer());
+        T& acc = partials[piece];
+        for (auto ptr = begin; ptr != end; ++ptr) {
+          combiner(acc, map_func(*ptr));
+        }
+      }
+    });
+
+    ForEach(hubs.data(), hubs.data() + hubs.size(),
+            [&identity, &combiner, &apply_func, &hubs, &piece_offsets,
+             &partials](uint32_t tid, const vertex_t* iter) {
+              size_t idx = iter - hubs.data();
+              T acc = identity;
+              for (size_t piece = piece_offsets[idx];
+                   piece != piece_offsets[idx + 1]; ++piece) {
+                combiner(acc, partials[piece]);
+              }
+              apply_func(tid, *iter, acc);
+            });
+  }
+
+  /**
+   * @brief Cut range into chunks with balanced cost, where the cost of a
+   * vertex is its degree plus one, bounds[i] and bounds[i + 1] delimit the
+   * i-th chunk.
+   */
+  template <typename VID_T, typename NBR_T>
+  void splitByEdges(const VertexRange<VID_T>& range,
+                    const NBR_T* const* offsets, std::vector<VID_T>& bounds) {
+    VID_T begin = range.begin().GetValue(), end = range.end().GetValue();
+    auto cost = [offsets, begin](VID_T v) -> size_t {
+      return (offsets[v] - offsets[begin]) + (v - begin);
+    };
+    size_t total_cost = cost(end);
+    size_t chunk_num =
+        std::min(static_cast<size_t>(thread_num_) * kChunksPerThread,
+                 static_cast<size_t>(end - begin));
+
+    bounds.clear();
+    bounds.push_back(begin);
+    for (size_t i = 1; i < chunk_num; ++i) {
+      size_t target = total_cost * i / chunk_num;
+      // find the first vertex whose prefix cost reaches target.
+      VID_T low = bounds.back(), high = end;
+      while (low < high) {
+        VID_T mid = low + (high - low) / 2;
+        if (cost(mid) < target) {
+          low = mid + 1;
+        } else {
+          high = mid;
+        }
+      }
+      if (low > bounds.back() && low < end) {
+        bounds.push_back(low);
+      }
+    }
+    bounds.push_back(end);
+  }
+
+  /**
+   * @brief Size of blocks the reduce, scan and filter primitives split n
+   * items into. It depends only on n and the thread number, which keeps the
+   * order of combining partial results fixed.
+   */
+  inline size_t blockSize(size_t n, size_t align) const {
+    size_t block_num = static_cast<size_t>(thread_num_) * kChunksPerThread;
+    size_t block_size = std::max((n + block_num - 1) / block_num,
+                                 static_cast<size_t>(1));
+    return (block_size + align - 1) / align * align;
+  }
+
+  /**
+   * @brief Invoke block_func(tid, block, from, to) on blocks of [0, n)
+   * concurrently, blocks are fetched by threads dynamically.
+   */
+  template <typename BLOCK_FUNC_T>
+  void forEachBlock(size_t n, size_t block_size,
+                    const BLOCK_FUNC_T& block_func) {
+    size_t block_num = (n + block_size - 1) / block_size;
+    if (block_num == 0) {
+      return;
+    }
+    std::atomic<size_t> cur(0);
+    runTask([&cur, &block_func, n, block_size, block_num](uint32_t tid) {
+      while (true) {
+        size_t block = cur.fetch_add(1);
+        if (block >= block_num) {
+          break;
+        }
+        block_func(tid, block, block * block_size,
+                   std::min(n, (block + 1) * block_size));
+      }
+    });
+  }
+
+  template <typename VID_T, typename FUNC_T>
+  static inline void forEachBit(const Bitset& bs, VID_T beg, size_t from,
+                                size_t to, const FUNC_T& func) {
+    for (size_t i = from; i < to; i += 64) {
+      Vertex<VID_T> v(beg + i);
+      uint64_t word = bs.get_word(i);
+      while (word != 0) {
+        if (word & 1) {
+          func(v);
+        }
+        ++v;
+        word = word >> 1;
+      }
+    }
+  }
+
+  template <typename T, typename BLOCK_FUNC_T, typename COMBINER_T>
+  T reduceBlocks(size_t n, size_t align, const T& identity,
+                 const BLOCK_FUNC_T& block_func, const COMBINER_T& combiner) {
+    size_t block_size = blockSize(n, align);
+    std::vector<T> partials((n + block_size - 1) / block_size, identity);
+    forEachBlock(n, block_size,
+                 [&partials, &identity, &block_func](
+                     uint32_t tid, size_t block, size_t from, size_t to) {
+                   T acc = identity;
+                   block_func(tid, from, to, acc);
+                   partials[block] = std::move(acc);
+                 });
+    T ret = identity;
+    for (auto& partial : partials) {
+      combiner(ret, partial);
+    }
+    return ret;
+  }
+
+  /**
+   * @brief Two-pass exclusive scan, sum_func(tid, from, to) returns the sum
+   * of a block, and scan_func(tid, from, to, offset) writes the prefix sums
+   * of a block starting from offset.
+   */
+  template <typename T, typename SUM_FUNC_T, typename SCAN_FUNC_T>
+  T scanBlocks(size_t n, const SUM_FUNC_T& sum_func,
+               const SCAN_FUNC_T& scan_func) {
+    size_t block_size = blockSize(n, 1);
+    size_t block_num = (n + block_size - 1) / block_size;
+    std::vector<T> offsets(block_num + 1, T());
+    forEachBlock(n, block_size,
+                 [&offsets, &sum_func](uint32_t tid, size_t block, size_t from,
+                                       size_t to) {
+                   offsets[block + 1] = sum_func(tid, from, to);
+                 });
+    for (size_t i = 0; i < block_num; ++i) {
+      offsets[i + 1] += offsets[i];
+    }
+    forEachBlock(n, block_size,
+                 [&offsets, &scan_func](uint32_t tid, size_t block,
+                                        size_t from, size_t to) {
+                   scan_func(tid, from, to, offsets[block]);
+                 });
+    return offsets[block_num];
+  }
+
+  template <typename T, typename BLOCK_FUNC_T>
+  void filterBlocks(size_t n, size_t align, const BLOCK_FUNC_T& block_func,
+                    std::vector<T>& out) {
+    size_t block_size = blockSize(n, align);
+    size_t block_num = (n + block_size - 1) / block_size;
+    std::vector<std::vector<T>> buffers(block_num);
+    forEachBlock(n, block_size,
+                 [&buffers, &block_func](uint32_t tid, size_t block,
+                                         size_t from, size_t to) {
+                   std::vector<T> buf;
+                   block_func(tid, from, to, buf);
+                   buffers[block].swap(buf);
+                 });
+    std::vector<size_t> offsets(block_num + 1, 0);
+    for (size_t i = 0; i < block_num; ++i) {
+      offsets[i + 1] = offsets[i] + buffers[i].size();
+    }
+    out.clear();
+    out.resize(offsets[block_num]);
+    forEachBlock(block_num, 1,
+                 [&buffers, &offsets, &out](uint32_t tid, size_t block,
+                                            size_t from, size_t to) {
+                   std::move(buffers[block].begin(), buffers[block].end(),
+                             out.begin() + offsets[block]);
+                 });
+  }
+
+  template <typename TASK_T>
+  inline void runTask(const TASK_T& task) {
+    if (!thread_pool_.Started()) {
+      thread_pool_.Start(thread_num_);
+    }
+    thread_pool_.RunTask(task);
   }
 
   bool affinity_;
   std::vector<uint32_t> cpu_list_;
   uint32_t thread_num_;
+  ThreadPool thread_pool_;
+
+  // NUMA nodes the threads are on, threads on node n are
+  // [node_thread_offsets_[n], node_thread_offsets_[n + 1]).
+  uint32_t numa_node_num_;
+  std::vector<uint32_t> node_thread_offsets_;
+  std::vector<uint32_t> thread_node_;
 };
 
 template <typename APP_T>
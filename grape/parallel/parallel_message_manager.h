@@ -18,20 +18,26 @@ limitations under the License.
 
 #include <mpi.h>
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <memory>
 #include <string>
 #include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "grape/communication/shm_transport.h"
 #include "grape/communication/sync_comm.h"
 #include "grape/parallel/message_manager_base.h"
 #include "grape/parallel/thread_local_message_buffer.h"
+#include "grape/parallel/typed_message_buffer.h"
 #include "grape/serialization/in_archive.h"
+#include "grape/serialization/message_codec.h"
 #include "grape/serialization/out_archive.h"
 #include "grape/utils/concurrent_queue.h"
+#include "grape/utils/cpu_topology.h"
 #include "grape/worker/comm_spec.h"
 
 namespace grape {
@@ -45,6 +51,9 @@ namespace grape {
  * For each thread local message buffer, when accumulated a given amount of
  * messages, the buffer will be sent through MPI.
  *
+ * Buffers are sent and received by a send thread and a recv thread, both of
+ * which live from Start to Finalize, so no thread is created per round.
+ *
  * After a round of evaluation, there is a global barrier to determine whether
  * the fixed point is reached.
  *
@@ -75,14 +84,58 @@ class ParallelMessageManager : public MessageManagerBase {
     recv_queues_[1].SetProducerNum(fnum_);
 
     round_ = 0;
+    encoder_ = NULL;
+    typed_tag_ = NULL;
 
     sent_size_ = 0;
+    speculative_ = false;
+    vote_pending_ = false;
+    to_terminate_ = false;
+  }
+
+  /**
+   * @brief Overlap the termination vote of a round with the next round.
+   *
+   * The vote is started with MPI_Iallreduce in FinishARound and completed in
+   * the FinishARound of the next round, so ToTerminate doesn't block. As a
+   * result, one more round is evaluated after the last active one. It only
+   * works with apps whose IncEval is a no-op on the results when no messages
+   * are received and no one forced to continue, i.e., apps declaring
+   * speculative_termination. Otherwise the blocking vote is used.
+   *
+   * @param speculative
+   */
+  void SetSpeculativeTermination(bool speculative) {
+    speculative_ = speculative;
+  }
+
+  /**
+   * @brief Exchange messages with co-located workers through shared memory,
+   * which is collective and expected after Init. Messages received are put
+   * into the receiving queues by the progress thread of the transport, as
+   * the recv thread does for messages through MPI.
+   *
+   * @param ring_size Capacity in bytes of the ring from each co-located
+   * worker.
+   */
+  void EnableShmTransport(size_t ring_size = ShmTransport::kDefaultRingSize) {
+    shm_.SetHandler([this](fid_t, int tag, OutArchive&& arc) {
+      if (arc.Empty()) {
+        recv_queues_[tag % 2].DecProducerNum();
+      } else {
+        recv_queues_[tag % 2].Put(std::move(arc));
+      }
+    });
+    shm_.Init(comm_spec_, ring_size);
   }
 
   /**
    * @brief Inherit
    */
-  void Start() override { startRecvThread(); }
+  void Start() override {
+    startRecvThread();
+    startSendThread();
+  }
 
   /**
    * @brief Inherit
@@ -101,22 +154,33 @@ class ParallelMessageManager : public MessageManagerBase {
       rq.DecProducerNum();
     }
     sent_size_ = 0;
-    startSendThread();
+    startSendRound();
   }
 
   /**
    * @brief Inherit
    */
   void FinishARound() override {
+    CHECK(process_threads_.empty())
+        << "WaitParallelProcess is expected before the end of a round.";
     sent_size_ = finishMsgFilling();
     resetRecvQueue();
     round_++;
+    if (speculative_) {
+      finishVote();
+      if (!to_terminate_) {
+        startVote();
+      }
+    }
   }
 
   /**
    * @brief Inherit
    */
   bool ToTerminate() override {
+    if (speculative_) {
+      return to_terminate_;
+    }
     int flag = 1;
     if (sent_size_ == 0 && !force_continue_) {
       flag = 0;
@@ -130,9 +194,15 @@ class ParallelMessageManager : public MessageManagerBase {
    * @brief Inherit
    */
   void Finalize() override {
+    if (vote_pending_) {
+      MPI_Wait(&vote_req_, MPI_STATUS_IGNORE);
+      vote_pending_ = false;
+    }
     waitSend();
+    stopSendThread();
     MPI_Barrier(comm_);
     stopRecvThread();
+    shm_.Finalize();
 
     MPI_Comm_free(&comm_);
     comm_ = NULL_COMM;
@@ -163,6 +233,91 @@ class ParallelMessageManager : public MessageManagerBase {
     for (auto& channel : channels_) {
       channel.Init(fnum_, this, block_size, block_cap);
     }
+    encoder_ = NULL;
+    typed_channels_.clear();
+    typed_tag_ = NULL;
+  }
+
+  /**
+   * @brief Init a set of typed channels in place of the channels, each of
+   * which is a TypedMessageBuffer, until the next InitChannels.
+   *
+   * Typed channels store gids and messages in arrays, and send them as raw
+   * regions, so that appending and processing a message is free of per-field
+   * serialization. All messages of the app are expected to be of MESSAGE_T
+   * and sent to vertices, and processed by ParallelProcess,
+   * ParallelProcessByOwner or ParallelProcessSpans with the same GRAPH_T and
+   * MESSAGE_T.
+   *
+   * @tparam GRAPH_T Graph type.
+   * @tparam MESSAGE_T Message type, a POD or EmptyType.
+   * @param channel_num Number of channels.
+   * @param block_size Size of each channel.
+   */
+  template <typename GRAPH_T, typename MESSAGE_T>
+  void InitTypedChannels(int channel_num = 1,
+                         size_t block_size = default_msg_send_block_size) {
+    using buffer_t = TypedMessageBuffer<ParallelMessageManager,
+                                        typename GRAPH_T::vid_t, MESSAGE_T>;
+    channels_.clear();
+    encoder_ = NULL;
+    typed_channels_.clear();
+    for (int i = 0; i < channel_num; ++i) {
+      buffer_t* channel = new buffer_t();
+      channel->Init(fnum_, this, block_size / buffer_t::kRecordSize);
+      typed_channels_.emplace_back(channel);
+    }
+    typed_tag_ = buffer_t::Tag();
+  }
+
+  /**
+   * @brief Get a typed channel initialized by InitTypedChannels.
+   *
+   * @tparam GRAPH_T Graph type.
+   * @tparam MESSAGE_T Message type.
+   * @param channel_id
+   */
+  template <typename GRAPH_T, typename MESSAGE_T>
+  inline TypedMessageBuffer<ParallelMessageManager, typename GRAPH_T::vid_t,
+                            MESSAGE_T>&
+  TypedChannel(int channel_id) {
+    using buffer_t = TypedMessageBuffer<ParallelMessageManager,
+                                        typename GRAPH_T::vid_t, MESSAGE_T>;
+    return *static_cast<buffer_t*>(typed_channels_[channel_id].get());
+  }
+
+  /**
+   * @brief Encode the blocks sent by channels with MessageCodec, i.e., gids
+   * sorted and delta coded as varints, until the next InitChannels.
+   *
+   * It applies to apps whose messages are all sent to vertices with POD or
+   * EmptyType messages of the same type, and processed by ParallelProcess or
+   * ParallelProcessByOwner with the same GRAPH_T and MESSAGE_T. It is
+   * expected to be enabled right after InitChannels in PEval, so that blocks
+   * of all the rounds are encoded.
+   *
+   * @tparam GRAPH_T Graph type.
+   * @tparam MESSAGE_T Message type.
+   */
+  template <typename GRAPH_T, typename MESSAGE_T>
+  void EnableCompression() {
+    CHECK(typed_channels_.empty())
+        << "Compression is not supported by typed channels.";
+    encoder_ = &MessageCodec<typename GRAPH_T::vid_t, MESSAGE_T>::Encode;
+    for (auto& channel : channels_) {
+      channel.SetEncoder(encoder_);
+    }
+  }
+
+  /**
+   * @brief Bind the send and recv threads to the given cpus, so that they
+   * don't compete with the computing threads. They will float over all the
+   * cpus if the list is empty.
+   *
+   * @param cpu_list Cpus reserved for communication.
+   */
+  void SetCommCpuList(const std::vector<uint32_t>& cpu_list) {
+    comm_cpu_list_ = cpu_list;
   }
 
   std::vector<ThreadLocalMessageBuffer<ParallelMessageManager>>& Channels() {
@@ -200,6 +355,28 @@ class ParallelMessageManager : public MessageManagerBase {
                                                                      msg);
   }
 
+  /**
+   * @brief SyncStateOnOuterVertex on a channel, messages to the same outer
+   * vertex are combined in the channel before being sent.
+   *
+   * @tparam GRAPH_T Graph type.
+   * @tparam MESSAGE_T Message type.
+   * @tparam COMBINER_T Combiner type.
+   * @param frag Source fragment.
+   * @param v Source vertex.
+   * @param msg
+   * @param channel_id
+   * @param combiner
+   */
+  template <typename GRAPH_T, typename MESSAGE_T, typename COMBINER_T>
+  inline void SyncStateOnOuterVertex(const GRAPH_T& frag,
+                                     const typename GRAPH_T::vertex_t& v,
+                                     const MESSAGE_T& msg, int channel_id,
+                                     const COMBINER_T& combiner) {
+    channels_[channel_id].SyncStateOnOuterVertex<GRAPH_T, MESSAGE_T>(
+        frag, v, msg, combiner);
+  }
+
   template <typename GRAPH_T>
   inline void SyncStateOnOuterVertex(const GRAPH_T& frag,
                                      const typename GRAPH_T::vertex_t& v,
@@ -279,22 +456,182 @@ class ParallelMessageManager : public MessageManagerBase {
     for (int i = 0; i < thread_num; ++i) {
       threads[i] = std::thread(
           [&](int tid) {
-            typename GRAPH_T::vid_t id;
-            typename GRAPH_T::vertex_t vertex;
-            MESSAGE_T msg;
             auto& que = recv_queues_[round_ % 2];
             OutArchive arc;
             while (que.Get(arc)) {
-              while (!arc.Empty()) {
-                arc >> id >> msg;
-                frag.Gid2Vertex(id, vertex);
-                func(tid, vertex, msg);
+              processArchive<GRAPH_T, MESSAGE_T>(
+                  frag, arc,
+                  [&](const typename GRAPH_T::vertex_t& vertex,
+                      MESSAGE_T& msg) { func(tid, vertex, msg); });
+            }
+          },
+          i);
+    }
+
+    for (auto& thrd : threads) {
+      thrd.join();
+    }
+  }
+
+  /**
+   * @brief Parallel process all incoming messages of last round, each
+   * message is processed by the thread owning its destination vertex.
+   *
+   * Inner vertices, i.e., destinations of messages, are split into
+   * thread_num consecutive slices, one for each thread. Archives are first
+   * decoded and bucketed by the slices of destinations, then each thread
+   * applies the messages of its own slice.
+   * As a vertex is only touched by its owner, func can update vertex states
+   * with plain stores instead of atomic operations, e.g., a min for SSSP.
+   *
+   * @tparam GRAPH_T Graph type.
+   * @tparam MESSAGE_T Message type.
+   * @tparam FUNC_T Function type.
+   * @param thread_num Number of threads.
+   * @param frag
+   * @param func
+   */
+  template <typename GRAPH_T, typename MESSAGE_T, typename FUNC_T>
+  inline void ParallelProcessByOwner(int thread_num, const GRAPH_T& frag,
+                                     const FUNC_T& func) {
+    using vertex_t = typename GRAPH_T::vertex_t;
+    using bucket_t = std::vector<std::pair<vertex_t, MESSAGE_T>>;
+    // buckets[i][j] holds messages decoded by thread i and owned by thread j.
+    std::vector<std::vector<bucket_t>> buckets(
+        thread_num, std::vector<bucket_t>(thread_num));
+    auto inner_vertices = frag.InnerVertices();
+    size_t slice_begin = inner_vertices.begin().GetValue();
+    size_t slice_size =
+        (static_cast<size_t>(inner_vertices.size()) + thread_num - 1) /
+        thread_num;
+    slice_size = std::max(slice_size, static_cast<size_t>(1));
+
+    std::vector<std::thread> threads(thread_num);
+    for (int i = 0; i < thread_num; ++i) {
+      threads[i] = std::thread(
+          [&](int tid) {
+            auto& que = recv_queues_[round_ % 2];
+            auto& local_buckets = buckets[tid];
+            OutArchive arc;
+            while (que.Get(arc)) {
+              processArchive<GRAPH_T, MESSAGE_T>(
+                  frag, arc, [&](const vertex_t& vertex, MESSAGE_T& msg) {
+                    size_t owner = std::min(
+                        (vertex.GetValue() - slice_begin) / slice_size,
+                        static_cast<size_t>(thread_num - 1));
+                    local_buckets[owner].emplace_back(vertex, std::move(msg));
+                  });
+            }
+          },
+          i);
+    }
+    for (auto& thrd : threads) {
+      thrd.join();
+    }
+
+    for (int i = 0; i < thread_num; ++i) {
+      threads[i] = std::thread(
+          [&](int tid) {
+            for (int src = 0; src < thread_num; ++src) {
+              bucket_t bucket;
+              bucket.swap(buckets[src][tid]);
+              for (auto& pair : bucket) {
+                func(tid, pair.first, pair.second);
               }
             }
           },
           i);
     }
+    for (auto& thrd : threads) {
+      thrd.join();
+    }
+  }
 
+  /**
+   * @brief Start processing incoming messages of last round in background
+   * threads, which returns immediately. The threads apply blocks as soon as
+   * they are received, so that apps can compute, e.g., by ForEach, while
+   * messages are still on the way, and WaitParallelProcess before using the
+   * complete result of messages.
+   *
+   * func runs concurrently with the computation, so it is expected to update
+   * vertex states with atomic operations and record the updated vertices
+   * apart from those being iterated. The threads are bound to the cpus for
+   * communication, and tids passed to func are in [0, thread_num).
+   *
+   * @tparam GRAPH_T Graph type.
+   * @tparam MESSAGE_T Message type.
+   * @tparam FUNC_T Function type, which is copied into the threads.
+   * @param thread_num Number of background threads.
+   * @param frag
+   * @param func
+   */
+  template <typename GRAPH_T, typename MESSAGE_T, typename FUNC_T>
+  inline void StartParallelProcess(int thread_num, const GRAPH_T& frag,
+                                   const FUNC_T& func) {
+    CHECK(process_threads_.empty());
+    for (int i = 0; i < thread_num; ++i) {
+      process_threads_.emplace_back(
+          [this, &frag, func](int tid) {
+            auto& que = recv_queues_[round_ % 2];
+            OutArchive arc;
+            while (que.Get(arc)) {
+              processArchive<GRAPH_T, MESSAGE_T>(
+                  frag, arc,
+                  [&](const typename GRAPH_T::vertex_t& vertex,
+                      MESSAGE_T& msg) { func(tid, vertex, msg); });
+            }
+          },
+          i);
+      BindThreadToCpus(process_threads_.back(), comm_cpu_list_);
+    }
+  }
+
+  /**
+   * @brief Wait until all incoming messages of last round are processed by
+   * StartParallelProcess.
+   */
+  inline void WaitParallelProcess() {
+    for (auto& thrd : process_threads_) {
+      thrd.join();
+    }
+    process_threads_.clear();
+  }
+
+  /**
+   * @brief Parallel process all incoming blocks of last round sent by typed
+   * channels, func(tid, gids, msgs, num) is invoked on each block with the
+   * spans of gids and messages, so that it can walk the arrays directly.
+   * msgs is NULL for EmptyType.
+   *
+   * @tparam GRAPH_T Graph type.
+   * @tparam MESSAGE_T Message type.
+   * @tparam FUNC_T Function type.
+   * @param thread_num Number of threads.
+   * @param func
+   */
+  template <typename GRAPH_T, typename MESSAGE_T, typename FUNC_T>
+  inline void ParallelProcessSpans(int thread_num, const FUNC_T& func) {
+    using vid_t = typename GRAPH_T::vid_t;
+    using buffer_t =
+        TypedMessageBuffer<ParallelMessageManager, vid_t, MESSAGE_T>;
+    CHECK(typed_tag_ == buffer_t::Tag())
+        << "Messages are processed with types other than the typed channels.";
+    std::vector<std::thread> threads(thread_num);
+    for (int i = 0; i < thread_num; ++i) {
+      threads[i] = std::thread(
+          [&](int tid) {
+            auto& que = recv_queues_[round_ % 2];
+            OutArchive arc;
+            const vid_t* gids;
+            const MESSAGE_T* msgs;
+            while (que.Get(arc)) {
+              size_t num = buffer_t::Parse(arc, gids, msgs);
+              func(tid, gids, msgs, num);
+            }
+          },
+          i);
+    }
     for (auto& thrd : threads) {
       thrd.join();
     }
@@ -336,45 +673,162 @@ class ParallelMessageManager : public MessageManagerBase {
     }
   }
 
- private:
-  void startSendThread() {
-    force_continue_ = false;
-    int round = round_;
+ protected:
+  /**
+   * @brief Decode the (gid, msg) records in a received block, with the codec
+   * enabled by EnableCompression if any, func(vertex, msg) is invoked on each
+   * record.
+   */
+  template <typename GRAPH_T, typename MESSAGE_T, typename FUNC_T>
+  inline void processArchive(const GRAPH_T& frag, OutArchive& arc,
+                             const FUNC_T& func) {
+    using vid_t = typename GRAPH_T::vid_t;
+    if (encoder_ != NULL || typed_tag_ != NULL) {
+      processEncodedArchive<GRAPH_T, MESSAGE_T>(
+          frag, arc, func, typename std::is_pod<MESSAGE_T>::type());
+      return;
+    }
+    typename GRAPH_T::vertex_t vertex;
+    vid_t id;
+    MESSAGE_T msg;
+    while (!arc.Empty()) {
+      arc >> id >> msg;
+      frag.Gid2Vertex(id, vertex);
+      func(vertex, msg);
+    }
+  }
 
-    CHECK_EQ(sending_queue_.Size(), 0);
-    sending_queue_.SetProducerNum(1);
-    send_thread_ = std::thread(
-        [this](int msg_round) {
-          std::vector<MPI_Request> reqs;
-          std::pair<fid_t, InArchive> item;
-          while (sending_queue_.Get(item)) {
-            if (item.second.GetSize() == 0) {
-              continue;
-            }
-            if (item.first == fid_) {
-              to_self_.emplace_back(std::move(item.second));
-            } else {
-              MPI_Request req;
-              MPI_Isend(item.second.GetBuffer(), item.second.GetSize(),
-                        MPI_CHAR, comm_spec_.FragToWorker(item.first),
-                        msg_round, comm_, &req);
-              reqs.push_back(req);
-              to_others_.emplace_back(std::move(item.second));
-            }
+  template <typename GRAPH_T, typename MESSAGE_T, typename FUNC_T>
+  inline void processEncodedArchive(const GRAPH_T& frag, OutArchive& arc,
+                                    const FUNC_T& func, std::true_type) {
+    using vid_t = typename GRAPH_T::vid_t;
+    typename GRAPH_T::vertex_t vertex;
+    if (typed_tag_ != NULL) {
+      using buffer_t =
+          TypedMessageBuffer<ParallelMessageManager, vid_t, MESSAGE_T>;
+      CHECK(typed_tag_ == buffer_t::Tag())
+          << "Messages are processed with types other than the typed "
+             "channels.";
+      const vid_t* gids;
+      const MESSAGE_T* msgs;
+      size_t num = buffer_t::Parse(arc, gids, msgs);
+      MESSAGE_T msg;
+      for (size_t i = 0; i < num; ++i) {
+        frag.Gid2Vertex(gids[i], vertex);
+        if (msgs != NULL) {
+          msg = msgs[i];
+        }
+        func(vertex, msg);
+      }
+      return;
+    }
+    using codec_t = MessageCodec<vid_t, MESSAGE_T>;
+    CHECK(encoder_ == &codec_t::Encode)
+        << "Messages are processed with types other than the compressed.";
+    codec_t::Decode(arc, [&](vid_t gid, MESSAGE_T& msg) {
+      frag.Gid2Vertex(gid, vertex);
+      func(vertex, msg);
+    });
+  }
+
+  template <typename GRAPH_T, typename MESSAGE_T, typename FUNC_T>
+  inline void processEncodedArchive(const GRAPH_T& frag, OutArchive& arc,
+                                    const FUNC_T& func, std::false_type) {
+    LOG(FATAL) << "Messages are processed with types other than the "
+                  "compressed or typed ones.";
+  }
+
+  /**
+   * @brief Start the send thread, which lives until Finalize. For each round,
+   * StartARound hands the message tag of the round over by send_rounds_, and
+   * the thread reports the tag by sent_rounds_ once all the messages of the
+   * round are sent.
+   */
+  void startSendThread() {
+    send_rounds_.SetProducerNum(1);
+    sent_rounds_.SetProducerNum(1);
+    send_thread_ = std::thread([this]() {
+      int msg_round;
+      std::vector<MPI_Request> reqs;
+      std::vector<ShmTransport::Request> shm_reqs;
+      std::pair<fid_t, InArchive> item;
+      while (send_rounds_.Get(msg_round)) {
+        while (sending_queue_.Get(item)) {
+          if (item.second.GetSize() == 0) {
+            continue;
           }
-          for (fid_t i = 0; i < fnum_; ++i) {
-            if (i == fid_) {
-              continue;
-            }
+          if (item.first == fid_) {
+            to_self_.emplace_back(std::move(item.second));
+          } else if (shm_.IsLocal(item.first)) {
+            shm_reqs.push_back(shm_.PostSend(item.first,
+                                             item.second.GetBuffer(),
+                                             item.second.GetSize(), msg_round));
+            to_others_.emplace_back(std::move(item.second));
+          } else {
             MPI_Request req;
-            MPI_Isend(NULL, 0, MPI_CHAR, comm_spec_.FragToWorker(i), msg_round,
-                      comm_, &req);
+            IsendBytes(item.second.GetBuffer(), item.second.GetSize(),
+                       comm_spec_.FragToWorker(item.first), msg_round, comm_,
+                       &req);
             reqs.push_back(req);
+            to_others_.emplace_back(std::move(item.second));
+          }
+        }
+        for (fid_t i = 0; i < fnum_; ++i) {
+          if (i == fid_) {
+            continue;
+          }
+          if (shm_.IsLocal(i)) {
+            shm_reqs.push_back(shm_.PostSend(i, NULL, 0, msg_round));
+            continue;
           }
-          MPI_Waitall(reqs.size(), &reqs[0], MPI_STATUSES_IGNORE);
-          to_others_.clear();
-        },
-        round + 1);
+          MPI_Request req;
+          MPI_Isend(NULL, 0, MPI_CHAR, comm_spec_.FragToWorker(i), msg_round,
+                    comm_, &req);
+          reqs.push_back(req);
+        }
+        MPI_Waitall(reqs.size(), &reqs[0], MPI_STATUSES_IGNORE);
+        reqs.clear();
+        ShmTransport::WaitAll(shm_reqs);
+        to_others_.clear();
+        sent_rounds_.Put(msg_round);
+      }
+    });
+    BindThreadToCpus(send_thread_, comm_cpu_list_);
+  }
+
+  void startVote() {
+    vote_flag_ = (sent_size_ == 0 && !force_continue_) ? 0 : 1;
+    MPI_Iallreduce(&vote_flag_, &vote_ret_, 1, MPI_INT, MPI_SUM, comm_,
+                   &vote_req_);
+    vote_pending_ = true;
+  }
+
+  // A round evaluated after a vote to terminate is speculative, it must
+  // neither send messages nor force to continue, so it's safe to stop.
+  void finishVote() {
+    if (!vote_pending_) {
+      return;
+    }
+    MPI_Wait(&vote_req_, MPI_STATUS_IGNORE);
+    vote_pending_ = false;
+    if (vote_ret_ == 0) {
+      CHECK(sent_size_ == 0 && !force_continue_)
+          << "Speculative round is expected to be a no-op.";
+      to_terminate_ = true;
+    }
+  }
+
+  void startSendRound() {
+    force_continue_ = false;
+
+    CHECK_EQ(sending_queue_.Size(), 0);
+    sending_queue_.SetProducerNum(1);
+    send_rounds_.Put(round_ + 1);
+  }
+
+  void stopSendThread() {
+    send_rounds_.DecProducerNum();
+    send_thread_.join();
   }
 
   void probeAllIncomingMessages() {
@@ -387,16 +841,14 @@ class ParallelMessageManager : public MessageManagerBase {
         return;
       }
       int tag = status.MPI_TAG;
-      int count;
-      MPI_Get_count(&status, MPI_CHAR, &count);
+      size_t count = GetBytesCount(status);
       if (count == 0) {
         MPI_Recv(NULL, 0, MPI_CHAR, status.MPI_SOURCE, tag, comm_,
                  MPI_STATUS_IGNORE);
         recv_queues_[tag % 2].DecProducerNum();
       } else {
         OutArchive arc(count);
-        MPI_Recv(arc.GetBuffer(), count, MPI_CHAR, status.MPI_SOURCE, tag,
-                 comm_, MPI_STATUS_IGNORE);
+        RecvBytes(arc.GetBuffer(), count, status.MPI_SOURCE, tag, comm_);
         recv_queues_[tag % 2].Put(std::move(arc));
       }
     }
@@ -416,16 +868,14 @@ class ParallelMessageManager : public MessageManagerBase {
         }
         gotMessage = 1;
         int tag = status.MPI_TAG;
-        int count;
-        MPI_Get_count(&status, MPI_CHAR, &count);
+        size_t count = GetBytesCount(status);
         if (count == 0) {
           MPI_Recv(NULL, 0, MPI_CHAR, status.MPI_SOURCE, tag, comm_,
                    MPI_STATUS_IGNORE);
           recv_queues_[tag % 2].DecProducerNum();
         } else {
           OutArchive arc(count);
-          MPI_Recv(arc.GetBuffer(), count, MPI_CHAR, status.MPI_SOURCE, tag,
-                   comm_, MPI_STATUS_IGNORE);
+          RecvBytes(arc.GetBuffer(), count, status.MPI_SOURCE, tag, comm_);
           recv_queues_[tag % 2].Put(std::move(arc));
         }
       } else {
@@ -460,6 +910,7 @@ class ParallelMessageManager : public MessageManagerBase {
       probeAllIncomingMessages();
 #endif
     });
+    BindThreadToCpus(recv_thread_, comm_cpu_list_);
   }
 
   void stopRecvThread() {
@@ -468,13 +919,25 @@ class ParallelMessageManager : public MessageManagerBase {
   }
 
   inline size_t finishMsgFilling() {
+    size_t ret = flushChannels();
+    sending_queue_.DecProducerNum();
+    return ret;
+  }
+
+  // flush messages in all the channels, returns the size of messages sent by
+  // them in this round.
+  inline size_t flushChannels() {
     size_t ret = 0;
     for (auto& channel : channels_) {
       channel.FlushMessages();
       ret += channel.SentMsgSize();
       channel.Reset();
     }
-    sending_queue_.DecProducerNum();
+    for (auto& channel : typed_channels_) {
+      channel->FlushMessages();
+      ret += channel->SentMsgSize();
+      channel->Reset();
+    }
     return ret;
   }
 
@@ -487,7 +950,11 @@ class ParallelMessageManager : public MessageManagerBase {
     curr_recv_queue.SetProducerNum(fnum_);
   }
 
-  void waitSend() { send_thread_.join(); }
+  void waitSend() {
+    int msg_round;
+    CHECK(sent_rounds_.Get(msg_round));
+    CHECK_EQ(msg_round, round_);
+  }
 
   fid_t fid_;
   fid_t fnum_;
@@ -499,16 +966,32 @@ class ParallelMessageManager : public MessageManagerBase {
   std::vector<InArchive> to_others_;
 
   std::vector<ThreadLocalMessageBuffer<ParallelMessageManager>> channels_;
+  std::vector<std::unique_ptr<TypedMessageBufferBase>> typed_channels_;
+  const void* typed_tag_;
   int round_;
+  void (*encoder_)(const InArchive&, InArchive&);
 
-  BlockingQueue<std::pair<fid_t, InArchive>> sending_queue_;
+  LockFreeQueue<std::pair<fid_t, InArchive>> sending_queue_;
+  // message tags of rounds to be sent and finished sending.
+  BlockingQueue<int> send_rounds_, sent_rounds_;
   std::thread send_thread_;
 
-  std::array<BlockingQueue<OutArchive>, 2> recv_queues_;
+  std::array<LockFreeQueue<OutArchive>, 2> recv_queues_;
   std::thread recv_thread_;
+  // transport to co-located workers, used if enabled.
+  ShmTransport shm_;
+  // threads processing messages in background, see StartParallelProcess.
+  std::vector<std::thread> process_threads_;
+  std::vector<uint32_t> comm_cpu_list_;
 
   bool force_continue_;
   size_t sent_size_;
+
+  bool speculative_;
+  bool vote_pending_;
+  bool to_terminate_;
+  int vote_flag_, vote_ret_;
+  MPI_Request vote_req_;
 };
 
 }  // namespace grape
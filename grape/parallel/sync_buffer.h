@@ -16,9 +16,13 @@ limitations under the License.
 #ifndef GRAPE_PARALLEL_SYNC_BUFFER_H_
 #define GRAPE_PARALLEL_SYNC_BUFFER_H_
 
+#include <functional>
+#include <type_traits>
 #include <typeinfo>
 #include <utility>
 
+#include "grape/utils/atomic_ops.h"
+#include "grape/utils/bitset.h"
 #include "grape/utils/vertex_array.h"
 
 namespace grape {
@@ -43,23 +47,83 @@ class ISyncBuffer {
   }
 };
 
+/**
+ * @brief An aggregator keeping the minimum value.
+ */
+template <typename T>
+struct MinAggregator {
+  inline bool operator()(T& lhs, T&& rhs) const {
+    if (lhs > rhs) {
+      lhs = rhs;
+      return true;
+    }
+    return false;
+  }
+};
+
+/**
+ * @brief An aggregator overwriting the value with the received one.
+ */
+template <typename T>
+struct OverwriteAggregator {
+  inline bool operator()(T& lhs, T&& rhs) const {
+    lhs = std::move(rhs);
+    return true;
+  }
+};
+
+/**
+ * @brief An aggregator keeping the minimum value atomically.
+ */
+template <typename T>
+struct AtomicMinAggregator {
+  inline bool operator()(T& lhs, T&& rhs) const { return atomic_min(lhs, rhs); }
+};
+
+/**
+ * @brief An aggregator keeping the maximum value atomically.
+ */
+template <typename T>
+struct AtomicMaxAggregator {
+  inline bool operator()(T& lhs, T&& rhs) const { return atomic_max(lhs, rhs); }
+};
+
+/**
+ * @brief An aggregator summing up values atomically.
+ */
+template <typename T>
+struct AtomicSumAggregator {
+  inline bool operator()(T& lhs, T&& rhs) const {
+    atomic_add(lhs, rhs);
+    return rhs != static_cast<T>(0);
+  }
+};
+
 /**
  * @brief SyncBuffer manages status on each vertex during the evaluation in auto
  * parallization.
  *
+ * The aggregator is invoked for each received message. A functor type, rather
+ * than the default std::function, can be specified so that it's inlined.
+ *
  * @tparam T
  * @tparam VID_T
+ * @tparam AGGREGATOR_T Type of the aggregator, callable as bool(T&, T&&),
+ * returns whether the value is updated.
  */
-template <typename T, typename VID_T>
+template <typename T, typename VID_T,
+          typename AGGREGATOR_T = std::function<bool(T&, T&&)>>
 class SyncBuffer : public ISyncBuffer {
  public:
+  using value_t = T;
+
   SyncBuffer() {}
   explicit SyncBuffer(VertexRange<VID_T> range)
       : data_(range), updated_(range, false), range_(range) {}
 
   bool updated(size_t begin, size_t length) const override {
     auto iter = updated_.begin() + begin;
-    auto end = updated_.begin() + length;
+    auto end = iter + length;
     for (; iter != end; ++iter) {
       if (*iter) {
         return true;
@@ -74,7 +138,7 @@ class SyncBuffer : public ISyncBuffer {
   inline const std::type_info& GetTypeId() const override { return typeid(T); }
 
   void Init(VertexRange<VID_T> range, const T& value,
-            const std::function<bool(T&, T&&)>& aggregator) {
+            const AGGREGATOR_T& aggregator) {
     range_ = range;
     data_.Init(range, value);
     updated_.Init(range, false);
@@ -102,11 +166,23 @@ class SyncBuffer : public ISyncBuffer {
     }
   }
 
+  /**
+   * @brief Invoke func(v) on updated vertices in range, in ascending order.
+   */
+  template <typename FUNC_T>
+  void ForEachUpdated(const VertexRange<VID_T>& range, const FUNC_T& func) {
+    for (auto v : range) {
+      if (updated_[v]) {
+        func(v);
+      }
+    }
+  }
+
   T& operator[](Vertex<VID_T> v) { return data_[v]; }
 
   const T& operator[](Vertex<VID_T> v) const { return data_[v]; }
 
-  void Swap(SyncBuffer<T, VID_T>& rhs) {
+  void Swap(SyncBuffer<T, VID_T, AGGREGATOR_T>& rhs) {
     data_.swap(rhs.data_);
     updated_.swap(rhs.updated_);
     range_.Swap(rhs.range_);
@@ -122,7 +198,174 @@ class SyncBuffer : public ISyncBuffer {
   VertexArray<bool, VID_T> updated_;
   VertexRange<VID_T> range_;
 
-  std::function<bool(T&, T&&)> aggregator_;
+  AGGREGATOR_T aggregator_;
+};
+
+/**
+ * @brief A SyncBuffer which can be updated by multiple threads concurrently,
+ * for arithmetic values.
+ *
+ * SetValue and Aggregate are lock-free, values are updated with CAS and the
+ * aggregator is expected to be atomic, e.g., AtomicMinAggregator. Updated
+ * vertices are tracked in an atomic bitset, and a summary bitset marks the
+ * words of it with bits set, so finding and iterating on updated vertices
+ * cost O(changed words) plus a scan of the summary, i.e., 1 bit per 64
+ * vertices.
+ *
+ * Updates are not expected to be concurrent with Reset and iterations, which
+ * happen in different phases of a round.
+ *
+ * @tparam T
+ * @tparam VID_T
+ * @tparam AGGREGATOR_T Type of the atomic aggregator, callable as
+ * bool(T&, T&&), returns whether the value is updated.
+ */
+template <typename T, typename VID_T, typename AGGREGATOR_T>
+class ConcurrentSyncBuffer : public ISyncBuffer {
+  static_assert(std::is_arithmetic<T>::value,
+                "ConcurrentSyncBuffer only supports arithmetic values.");
+
+ public:
+  using value_t = T;
+
+  ConcurrentSyncBuffer() {}
+
+  bool updated(size_t begin, size_t length) const override {
+    bool ret = false;
+    forEachDirtyWord(begin, begin + length,
+                     [&ret](size_t word_id, uint64_t word) {
+                       ret = true;
+                       return false;
+                     });
+    return ret;
+  }
+
+  void* data() override {
+    return reinterpret_cast<void*>(&data_[range_.begin()]);
+  }
+
+  inline const std::type_info& GetTypeId() const override { return typeid(T); }
+
+  void Init(VertexRange<VID_T> range, const T& value,
+            const AGGREGATOR_T& aggregator) {
+    range_ = range;
+    data_.Init(range, value);
+    dirty_.init(range.size());
+    summary_.init((range.size() + 63) / 64);
+    aggregator_ = aggregator;
+  }
+
+  void SetValue(Vertex<VID_T> v, const T& value) {
+    T& ref = data_[v];
+    T old_value = ref;
+    while (old_value != value) {
+      if (atomic_compare_and_swap(ref, old_value, value)) {
+        markDirty(index(v));
+        return;
+      }
+      old_value = ref;
+    }
+  }
+
+  T& GetValue(Vertex<VID_T> v) { return data_[v]; }
+
+  bool IsUpdated(Vertex<VID_T> v) const { return dirty_.get_bit(index(v)); }
+
+  void SetUpdated(Vertex<VID_T> v) { markDirty(index(v)); }
+
+  void Reset(Vertex<VID_T> v) { dirty_.reset_bit(index(v)); }
+
+  void Reset(VertexRange<VID_T> range) {
+    ForEachUpdated(range, [this](Vertex<VID_T> v) { Reset(v); });
+  }
+
+  T& operator[](Vertex<VID_T> v) { return data_[v]; }
+
+  const T& operator[](Vertex<VID_T> v) const { return data_[v]; }
+
+  void Aggregate(Vertex<VID_T> v, T&& rhs) {
+    if (aggregator_(data_[v], std::move(rhs))) {
+      markDirty(index(v));
+    }
+  }
+
+  /**
+   * @brief Invoke func(v) on updated vertices in range, in ascending order.
+   * It can be invoked by multiple threads on disjoint ranges.
+   */
+  template <typename FUNC_T>
+  void ForEachUpdated(const VertexRange<VID_T>& range, const FUNC_T& func) {
+    size_t begin = index(range.begin());
+    size_t end = index(range.end());
+    VID_T offset = range_.begin().GetValue();
+    forEachDirtyWord(begin, end,
+                     [this, &func, offset](size_t word_id, uint64_t word) {
+                       size_t base = word_id << 6;
+                       while (word != 0) {
+                         func(Vertex<VID_T>(offset + base +
+                                            __builtin_ctzll(word)));
+                         word &= word - 1;
+                       }
+                       // drop the word from the summary if func reset all
+                       // the vertices in it.
+                       if (dirty_.get_word(base) == 0) {
+                         summary_.reset_bit(word_id);
+                       }
+                       return true;
+                     });
+  }
+
+ private:
+  inline size_t index(Vertex<VID_T> v) const {
+    return v.GetValue() - range_.begin().GetValue();
+  }
+
+  inline void markDirty(size_t i) {
+    if (dirty_.set_bit_with_ret(i) && !summary_.get_bit(i >> 6)) {
+      summary_.set_bit(i >> 6);
+    }
+  }
+
+  // Invoke func(word_id, word) on non-zero words of dirty bits in [begin,
+  // end), bits out of the range are masked. Stop if func returns false.
+  template <typename FUNC_T>
+  void forEachDirtyWord(size_t begin, size_t end, const FUNC_T& func) const {
+    if (begin >= end) {
+      return;
+    }
+    size_t word_id = begin >> 6;
+    size_t word_end = ((end - 1) >> 6) + 1;
+    while (word_id < word_end) {
+      uint64_t summary = summary_.get_word(word_id) >> (word_id & 63);
+      if (summary == 0) {
+        word_id = (word_id | 63) + 1;
+        continue;
+      }
+      word_id += __builtin_ctzll(summary);
+      if (word_id >= word_end) {
+        break;
+      }
+      size_t base = word_id << 6;
+      uint64_t word = dirty_.get_word(base);
+      if (base < begin) {
+        word &= ~0ul << (begin - base);
+      }
+      if (base + 64 > end) {
+        word &= (1ul << (end - base)) - 1;
+      }
+      if (word != 0 && !func(word_id, word)) {
+        return;
+      }
+      ++word_id;
+    }
+  }
+
+  VertexArray<T, VID_T> data_;
+  Bitset dirty_;
+  Bitset summary_;
+  VertexRange<VID_T> range_;
+
+  AGGREGATOR_T aggregator_;
 };
 }  // namespace grape
 
@@ -22,9 +22,81 @@ limitations under the License.
 
 #include "grape/graph/adj_list.h"
 #include "grape/serialization/in_archive.h"
+#include "grape/serialization/message_codec.h"
+#include "grape/utils/vertex_array.h"
 
 namespace grape {
 
+class CombineBufferBase {
+ public:
+  virtual ~CombineBufferBase() {}
+
+  /**
+   * @brief Serialize the combined messages to the buffers of destination
+   * fragments, and reset the combine buffer.
+   */
+  virtual void Flush(std::vector<InArchive>& to_send) = 0;
+};
+
+/**
+ * @brief A buffer combining messages sent to the same outer vertex, which is
+ * dense over the outer vertices of a fragment.
+ *
+ * @tparam VID_T Vertex ID type.
+ * @tparam MESSAGE_T Message type.
+ */
+template <typename VID_T, typename MESSAGE_T>
+class CombineBuffer : public CombineBufferBase {
+  struct Entry {
+    fid_t fid;
+    VID_T gid;
+    VID_T offset;
+  };
+
+ public:
+  explicit CombineBuffer(const VertexRange<VID_T>& outer_vertices)
+      : begin_(outer_vertices.begin().GetValue()),
+        messages_(outer_vertices.size()),
+        touched_(outer_vertices.size(), false) {}
+
+  /**
+   * @brief An address identifying the type of combine buffers.
+   */
+  static const void* Tag() {
+    static const char tag = 0;
+    return &tag;
+  }
+
+  template <typename GRAPH_T, typename COMBINER_T>
+  inline void Combine(const GRAPH_T& frag, const Vertex<VID_T>& v,
+                      const MESSAGE_T& msg, const COMBINER_T& combiner) {
+    VID_T offset = v.GetValue() - begin_;
+    if (touched_[offset]) {
+      combiner(messages_[offset], msg);
+    } else {
+      touched_[offset] = true;
+      messages_[offset] = msg;
+      entries_.push_back(
+          Entry{frag.GetFragId(v), frag.GetOuterVertexGid(v), offset});
+    }
+  }
+
+  void Flush(std::vector<InArchive>& to_send) override {
+    for (auto& entry : entries_) {
+      to_send[entry.fid] << entry.gid << messages_[entry.offset];
+      touched_[entry.offset] = false;
+    }
+    entries_.clear();
+  }
+
+ private:
+  VID_T begin_;
+  std::vector<MESSAGE_T> messages_;
+  std::vector<bool> touched_;
+  // outer vertices touched since the last flush, in the order of touching.
+  std::vector<Entry> entries_;
+};
+
 template <typename MM_T>
 class ThreadLocalMessageBuffer {
  public:
@@ -50,9 +122,26 @@ class ThreadLocalMessageBuffer {
       arc.Reserve(block_cap_);
     }
 
+    combine_buffer_.reset();
+    combine_tag_ = NULL;
+    encoder_ = NULL;
+
     sent_size_ = 0;
   }
 
+  /**
+   * @brief Set the function encoding a block before it is sent, e.g.,
+   * MessageCodec::Encode. Blocks are sent as they are if encoder is NULL.
+   *
+   * Encoding requires all messages in this buffer to be gid-addressed
+   * records of the same type, so SendToFragment should not be mixed with it.
+   *
+   * @param encoder
+   */
+  void SetEncoder(void (*encoder)(const InArchive&, InArchive&)) {
+    encoder_ = encoder;
+  }
+
   /**
    * @brief Communication by synchronizing the status on outer vertices, for
    * edge-cut fragments.
@@ -78,6 +167,41 @@ class ThreadLocalMessageBuffer {
     }
   }
 
+  /**
+   * @brief Synchronize the status on outer vertices, with messages to the
+   * same outer vertex combined in this buffer until FlushMessages, e.g., by
+   * MinCombiner in SSSP. So each outer vertex gets at most one message from
+   * this buffer in a round, no matter how many times it is updated.
+   *
+   * The combine buffer is dense over the outer vertices, one message type is
+   * expected to be combined in a round.
+   *
+   * @tparam GRAPH_T Graph type.
+   * @tparam MESSAGE_T Message type.
+   * @tparam COMBINER_T Combiner type, with signature void(MESSAGE_T&, const
+   * MESSAGE_T&), see grape/utils/combiners.h.
+   * @param frag Source fragment.
+   * @param v: a
+   * @param msg
+   * @param combiner Function combining the second message into the first one.
+   */
+  template <typename GRAPH_T, typename MESSAGE_T, typename COMBINER_T>
+  inline void SyncStateOnOuterVertex(const GRAPH_T& frag,
+                                     const typename GRAPH_T::vertex_t& v,
+                                     const MESSAGE_T& msg,
+                                     const COMBINER_T& combiner) {
+    using buffer_t = CombineBuffer<typename GRAPH_T::vid_t, MESSAGE_T>;
+    if (combine_tag_ != buffer_t::Tag()) {
+      if (combine_buffer_ != NULL) {
+        combine_buffer_->Flush(to_send_);
+      }
+      combine_buffer_.reset(new buffer_t(frag.OuterVertices()));
+      combine_tag_ = buffer_t::Tag();
+    }
+    static_cast<buffer_t*>(combine_buffer_.get())
+        ->Combine(frag, v, msg, combiner);
+  }
+
   template <typename GRAPH_T>
   inline void SyncStateOnOuterVertex(const GRAPH_T& frag,
                                      const typename GRAPH_T::vertex_t& v) {
@@ -182,6 +306,9 @@ class ThreadLocalMessageBuffer {
    * @brief Flush messages to message manager.
    */
   inline void FlushMessages() {
+    if (combine_buffer_ != NULL) {
+      combine_buffer_->Flush(to_send_);
+    }
     for (fid_t fid = 0; fid < fnum_; ++fid) {
       if (to_send_[fid].GetSize() > 0) {
         sent_size_ += to_send_[fid].GetSize();
@@ -196,11 +323,21 @@ class ThreadLocalMessageBuffer {
 
  private:
   inline void flushLocalBuffer(fid_t fid) {
+    if (encoder_ != NULL) {
+      InArchive encoded;
+      encoder_(to_send_[fid], encoded);
+      to_send_[fid].Clear();
+      mm_->SendRawMsgByFid(fid, std::move(encoded));
+      return;
+    }
     mm_->SendRawMsgByFid(fid, std::move(to_send_[fid]));
     to_send_[fid].Reserve(block_cap_);
   }
 
   std::vector<InArchive> to_send_;
+  std::unique_ptr<CombineBufferBase> combine_buffer_;
+  const void* combine_tag_;
+  void (*encoder_)(const InArchive&, InArchive&);
   MM_T* mm_;
   fid_t fnum_;
 
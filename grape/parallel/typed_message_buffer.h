@@ -0,0 +1,255 @@
+/** Copyright 2020 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef GRAPE_PARALLEL_TYPED_MESSAGE_BUFFER_H_
+#define GRAPE_PARALLEL_TYPED_MESSAGE_BUFFER_H_
+
+#include <glog/logging.h>
+#include <string.h>
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "grape/graph/adj_list.h"
+#include "grape/serialization/in_archive.h"
+#include "grape/serialization/out_archive.h"
+#include "grape/types.h"
+
+namespace grape {
+
+class TypedMessageBufferBase {
+ public:
+  virtual ~TypedMessageBufferBase() {}
+
+  /**
+   * @brief Flush messages to message manager.
+   */
+  virtual void FlushMessages() = 0;
+
+  virtual size_t SentMsgSize() const = 0;
+
+  virtual void Reset() = 0;
+};
+
+/**
+ * @brief A thread local message buffer for fixed-size messages addressed by
+ * gids, which stores gids and messages in separate preallocated arrays, i.e.,
+ * struct-of-arrays, instead of appending them field by field to archives.
+ *
+ * A block is sent as a header of the number of records, followed by the raw
+ * region of gids, padded to 8 bytes, and the raw region of messages. The
+ * receiver gets both regions as spans with Parse, without copying.
+ *
+ * @tparam MM_T Message manager type.
+ * @tparam VID_T Vertex ID type.
+ * @tparam MESSAGE_T Message type, a POD or EmptyType.
+ */
+template <typename MM_T, typename VID_T, typename MESSAGE_T>
+class TypedMessageBuffer : public TypedMessageBufferBase {
+  static_assert(std::is_pod<MESSAGE_T>::value,
+                "Only POD messages can be sent with typed buffers.");
+
+  static constexpr size_t kMsgSize =
+      std::is_same<MESSAGE_T, EmptyType>::value ? 0 : sizeof(MESSAGE_T);
+  static constexpr size_t kAlignment = 8;
+
+ public:
+  static constexpr size_t kRecordSize = sizeof(VID_T) + kMsgSize;
+
+  /**
+   * @brief Initialize the typed message buffer.
+   *
+   * @param fnum Number of fragments.
+   * @param mm MessageManager pointer.
+   * @param block_num Number of records in a block.
+   */
+  void Init(fid_t fnum, MM_T* mm, size_t block_num) {
+    fnum_ = fnum;
+    mm_ = mm;
+    block_num_ = std::max(block_num, static_cast<size_t>(1));
+
+    gids_.clear();
+    gids_.resize(fnum_, std::vector<VID_T>(block_num_));
+    msgs_.clear();
+    msgs_.resize(fnum_, std::vector<MESSAGE_T>(kMsgSize == 0 ? 0 : block_num_));
+    sizes_.clear();
+    sizes_.resize(fnum_, 0);
+
+    sent_size_ = 0;
+  }
+
+  /**
+   * @brief An address identifying the type of typed buffers.
+   */
+  static const void* Tag() {
+    static const char tag = 0;
+    return &tag;
+  }
+
+  /**
+   * @brief Get the spans of gids and messages in a block. Messages are
+   * pointed to NULL for EmptyType.
+   *
+   * @param arc A block sent by a typed buffer.
+   * @param gids
+   * @param msgs
+   * @return Number of records in the block.
+   */
+  static size_t Parse(OutArchive& arc, const VID_T*& gids,
+                      const MESSAGE_T*& msgs) {
+    size_t num;
+    arc >> num;
+    gids = reinterpret_cast<const VID_T*>(arc.GetBytes(gidRegionSize(num)));
+    msgs = kMsgSize == 0 ? NULL
+                         : reinterpret_cast<const MESSAGE_T*>(
+                               arc.GetBytes(kMsgSize * num));
+    CHECK(arc.Empty());
+    return num;
+  }
+
+  /**
+   * @brief Communication by synchronizing the status on outer vertices, for
+   * edge-cut fragments.
+   *
+   * @tparam GRAPH_T Graph type.
+   * @param frag Source fragment.
+   * @param v: a
+   * @param msg
+   */
+  template <typename GRAPH_T>
+  inline void SyncStateOnOuterVertex(const GRAPH_T& frag,
+                                     const typename GRAPH_T::vertex_t& v,
+                                     const MESSAGE_T& msg) {
+    append(frag.GetFragId(v), frag.GetOuterVertexGid(v), msg);
+  }
+
+  /**
+   * @brief Communication via a crossing edge a<-c. It sends message
+   * from a to c.
+   *
+   * @tparam GRAPH_T Graph type.
+   * @param frag Source fragment.
+   * @param v: a
+   * @param msg
+   */
+  template <typename GRAPH_T>
+  inline void SendMsgThroughIEdges(const GRAPH_T& frag,
+                                   const typename GRAPH_T::vertex_t& v,
+                                   const MESSAGE_T& msg) {
+    appendToDests(frag.IEDests(v), frag.GetInnerVertexGid(v), msg);
+  }
+
+  /**
+   * @brief Communication via a crossing edge a->b. It sends message
+   * from a to b.
+   *
+   * @tparam GRAPH_T Graph type.
+   * @param frag Source fragment.
+   * @param v: a
+   * @param msg
+   */
+  template <typename GRAPH_T>
+  inline void SendMsgThroughOEdges(const GRAPH_T& frag,
+                                   const typename GRAPH_T::vertex_t& v,
+                                   const MESSAGE_T& msg) {
+    appendToDests(frag.OEDests(v), frag.GetInnerVertexGid(v), msg);
+  }
+
+  /**
+   * @brief Communication via crossing edges a->b and a<-c. It sends message
+   * from a to b and c.
+   *
+   * @tparam GRAPH_T Graph type.
+   * @param frag Source fragment.
+   * @param v: a
+   * @param msg
+   */
+  template <typename GRAPH_T>
+  inline void SendMsgThroughEdges(const GRAPH_T& frag,
+                                  const typename GRAPH_T::vertex_t& v,
+                                  const MESSAGE_T& msg) {
+    appendToDests(frag.IOEDests(v), frag.GetInnerVertexGid(v), msg);
+  }
+
+  void FlushMessages() override {
+    for (fid_t fid = 0; fid < fnum_; ++fid) {
+      if (sizes_[fid] > 0) {
+        sent_size_ += sizes_[fid] * kRecordSize;
+        flushLocalBuffer(fid);
+      }
+    }
+  }
+
+  size_t SentMsgSize() const override { return sent_size_; }
+
+  void Reset() override { sent_size_ = 0; }
+
+ private:
+  static size_t gidRegionSize(size_t num) {
+    return (num * sizeof(VID_T) + kAlignment - 1) / kAlignment * kAlignment;
+  }
+
+  inline void appendToDests(const DestList& dsts, VID_T gid,
+                            const MESSAGE_T& msg) {
+    fid_t* ptr = dsts.begin;
+    while (ptr != dsts.end) {
+      append(*(ptr++), gid, msg);
+    }
+  }
+
+  inline void append(fid_t fid, VID_T gid, const MESSAGE_T& msg) {
+    size_t& size = sizes_[fid];
+    gids_[fid][size] = gid;
+    if (kMsgSize != 0) {
+      msgs_[fid][size] = msg;
+    }
+    if (++size == block_num_) {
+      flushLocalBuffer(fid);
+    }
+  }
+
+  inline void flushLocalBuffer(fid_t fid) {
+    size_t num = sizes_[fid];
+    size_t gid_region = gidRegionSize(num);
+    InArchive arc;
+    arc.Resize(sizeof(size_t) + gid_region + kMsgSize * num);
+    char* ptr = arc.GetBuffer();
+    memcpy(ptr, &num, sizeof(size_t));
+    ptr += sizeof(size_t);
+    memcpy(ptr, gids_[fid].data(), num * sizeof(VID_T));
+    ptr += gid_region;
+    if (kMsgSize != 0) {
+      memcpy(ptr, msgs_[fid].data(), kMsgSize * num);
+    }
+    sizes_[fid] = 0;
+    mm_->SendRawMsgByFid(fid, std::move(arc));
+  }
+
+  std::vector<std::vector<VID_T>> gids_;
+  std::vector<std::vector<MESSAGE_T>> msgs_;
+  std::vector<size_t> sizes_;
+  MM_T* mm_;
+  fid_t fnum_;
+
+  size_t block_num_;
+
+  size_t sent_size_;
+};
+
+}  // namespace grape
+
+#endif  // GRAPE_PARALLEL_TYPED_MESSAGE_BUFFER_H_
@@ -0,0 +1,336 @@
+/** Copyright 2020 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef GRAPE_SERIALIZATION_MESSAGE_CODEC_H_
+#define GRAPE_SERIALIZATION_MESSAGE_CODEC_H_
+
+#include <glog/logging.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "grape/serialization/in_archive.h"
+#include "grape/serialization/out_archive.h"
+#include "grape/types.h"
+
+namespace grape {
+
+/**
+ * @brief Append an unsigned integer to an archive as a varint, 7 bits per
+ * byte with the highest bit indicating whether more bytes follow.
+ */
+inline void EncodeVarint(uint64_t value, InArchive& arc) {
+  char buf[10];
+  int len = 0;
+  while (value >= 0x80) {
+    buf[len++] = static_cast<char>((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  buf[len++] = static_cast<char>(value);
+  arc.AddBytes(buf, len);
+}
+
+/**
+ * @brief Read a varint from an archive.
+ */
+inline uint64_t DecodeVarint(OutArchive& arc) {
+  uint64_t value = 0;
+  int shift = 0;
+  while (true) {
+    uint8_t byte = *static_cast<uint8_t*>(arc.GetBytes(1));
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      return value;
+    }
+    shift += 7;
+  }
+}
+
+/**
+ * @brief Compact encoding of message blocks addressed by gids.
+ *
+ * A raw block is a sequence of (gid, msg) records as written by
+ * ThreadLocalMessageBuffer, where msg is a POD or EmptyType. The encoded
+ * block is the number of records as a varint, followed by the records sorted
+ * by gid, each of which is the varint delta from the previous gid and the raw
+ * bytes of msg. Gids to a fragment are dense, so a gid mostly takes 1 or 2
+ * bytes instead of sizeof(VID_T).
+ *
+ * @tparam VID_T Vertex ID type.
+ * @tparam MESSAGE_T Message type.
+ */
+template <typename VID_T, typename MESSAGE_T>
+struct MessageCodec {
+  static_assert(std::is_pod<MESSAGE_T>::value,
+                "Only POD messages can be encoded.");
+
+  static constexpr size_t kMsgSize =
+      std::is_same<MESSAGE_T, EmptyType>::value ? 0 : sizeof(MESSAGE_T);
+  static constexpr size_t kRecordSize = sizeof(VID_T) + kMsgSize;
+
+  /**
+   * @brief Encode a raw block into out, order of messages to the same gid is
+   * preserved.
+   */
+  static void Encode(const InArchive& raw, InArchive& out) {
+    CHECK_EQ(raw.GetSize() % kRecordSize, 0);
+    size_t num = raw.GetSize() / kRecordSize;
+    std::vector<std::pair<VID_T, MESSAGE_T>> records(num);
+    const char* ptr = raw.GetBuffer();
+    for (size_t i = 0; i < num; ++i) {
+      memcpy(&records[i].first, ptr, sizeof(VID_T));
+      if (kMsgSize != 0) {
+        memcpy(&records[i].second, ptr + sizeof(VID_T), kMsgSize);
+      }
+      ptr += kRecordSize;
+    }
+    std::stable_sort(records.begin(), records.end(),
+                     [](const std::pair<VID_T, MESSAGE_T>& lhs,
+                        const std::pair<VID_T, MESSAGE_T>& rhs) {
+                       return lhs.first < rhs.first;
+                     });
+
+    out.Clear();
+    out.Reserve(raw.GetSize() / 2 + 10);
+    EncodeVarint(num, out);
+    VID_T prev = 0;
+    for (auto& record : records) {
+      EncodeVarint(static_cast<uint64_t>(record.first - prev), out);
+      if (kMsgSize != 0) {
+        out.AddBytes(&record.second, kMsgSize);
+      }
+      prev = record.first;
+    }
+  }
+
+  /**
+   * @brief Decode an encoded block, func(gid, msg) is invoked on each record.
+   */
+  template <typename FUNC_T>
+  static void Decode(OutArchive& arc, const FUNC_T& func) {
+    while (!arc.Empty()) {
+      size_t num = DecodeVarint(arc);
+      VID_T gid = 0;
+      MESSAGE_T msg;
+      for (size_t i = 0; i < num; ++i) {
+        gid += static_cast<VID_T>(DecodeVarint(arc));
+        if (kMsgSize != 0) {
+          memcpy(&msg, arc.GetBytes(kMsgSize), kMsgSize);
+        }
+        func(gid, msg);
+      }
+    }
+  }
+};
+
+/**
+ * @brief Lossy encodings of floating-point values, kNone keeps values raw.
+ */
+enum class LossyCodecType : uint8_t {
+  kNone = 0,
+  kFloat = 1,
+  kBFloat16 = 2,
+  kFixedPoint = 3,
+};
+
+/**
+ * @brief Lossy encoding of a block of floating-point values, e.g., the ranks
+ * of mirrors in PageRank.
+ *
+ * Values are encoded as floats, bfloat16s, or 16-bit fixed-point numbers
+ * scaled by the maximum magnitude in the block. Choose falls back to kNone
+ * for a block holding non-finite values, or any value decoded with an
+ * absolute error larger than max_error, so the error bound always holds.
+ * Encoded blocks are padded to 8 bytes.
+ *
+ * @tparam T Value type, float or double.
+ */
+template <typename T>
+struct LossyCodec {
+  static_assert(std::is_floating_point<T>::value,
+                "Only floating-point values can be encoded lossily.");
+
+  static constexpr size_t kAlignment = 8;
+  static constexpr double kFixedPointMax = 32767;
+
+  static size_t Padded(size_t size) {
+    return (size + kAlignment - 1) / kAlignment * kAlignment;
+  }
+
+  /**
+   * @brief Size of num values encoded with type.
+   */
+  static size_t EncodedSize(LossyCodecType type, size_t num) {
+    switch (type) {
+    case LossyCodecType::kFloat:
+      return Padded(num * sizeof(float));
+    case LossyCodecType::kBFloat16:
+      return Padded(num * sizeof(uint16_t));
+    case LossyCodecType::kFixedPoint:
+      return sizeof(double) + Padded(num * sizeof(int16_t));
+    default:
+      return Padded(num * sizeof(T));
+    }
+  }
+
+  /**
+   * @brief Upper bound of the encoded size of num values.
+   */
+  static size_t MaxEncodedSize(size_t num) {
+    return std::max(EncodedSize(LossyCodecType::kNone, num),
+                    EncodedSize(LossyCodecType::kFixedPoint, num));
+  }
+
+  /**
+   * @brief Choose the encoding of a block, type if the error bound holds,
+   * otherwise kNone. max_error <= 0 means unbounded.
+   */
+  static LossyCodecType Choose(const T* values, size_t num,
+                               LossyCodecType type, double max_error) {
+    if (type == LossyCodecType::kNone) {
+      return type;
+    }
+    double scale = fixedScale(values, num);
+    for (size_t i = 0; i < num; ++i) {
+      double v = values[i];
+      if (!std::isfinite(v)) {
+        return LossyCodecType::kNone;
+      }
+      double decoded = static_cast<T>(roundTrip(type, v, scale));
+      if (max_error > 0 && !(std::fabs(decoded - v) <= max_error)) {
+        return LossyCodecType::kNone;
+      }
+    }
+    return type;
+  }
+
+  /**
+   * @brief Encode a block with type to out, which holds EncodedSize bytes.
+   */
+  static void Encode(const T* values, size_t num, LossyCodecType type,
+                     char* out) {
+    switch (type) {
+    case LossyCodecType::kFloat: {
+      float* ptr = reinterpret_cast<float*>(out);
+      for (size_t i = 0; i < num; ++i) {
+        ptr[i] = static_cast<float>(values[i]);
+      }
+      break;
+    }
+    case LossyCodecType::kBFloat16: {
+      uint16_t* ptr = reinterpret_cast<uint16_t*>(out);
+      for (size_t i = 0; i < num; ++i) {
+        ptr[i] = toBFloat16(static_cast<float>(values[i]));
+      }
+      break;
+    }
+    case LossyCodecType::kFixedPoint: {
+      double scale = fixedScale(values, num);
+      memcpy(out, &scale, sizeof(double));
+      int16_t* ptr = reinterpret_cast<int16_t*>(out + sizeof(double));
+      for (size_t i = 0; i < num; ++i) {
+        ptr[i] = toFixedPoint(values[i], scale);
+      }
+      break;
+    }
+    default:
+      memcpy(out, values, num * sizeof(T));
+    }
+  }
+
+  /**
+   * @brief Decode a block encoded with type.
+   */
+  static void Decode(const char* in, size_t num, LossyCodecType type,
+                     T* values) {
+    switch (type) {
+    case LossyCodecType::kFloat: {
+      const float* ptr = reinterpret_cast<const float*>(in);
+      for (size_t i = 0; i < num; ++i) {
+        values[i] = static_cast<T>(ptr[i]);
+      }
+      break;
+    }
+    case LossyCodecType::kBFloat16: {
+      const uint16_t* ptr = reinterpret_cast<const uint16_t*>(in);
+      for (size_t i = 0; i < num; ++i) {
+        values[i] = static_cast<T>(fromBFloat16(ptr[i]));
+      }
+      break;
+    }
+    case LossyCodecType::kFixedPoint: {
+      double scale;
+      memcpy(&scale, in, sizeof(double));
+      const int16_t* ptr =
+          reinterpret_cast<const int16_t*>(in + sizeof(double));
+      for (size_t i = 0; i < num; ++i) {
+        values[i] = static_cast<T>(ptr[i] * scale);
+      }
+      break;
+    }
+    default:
+      memcpy(values, in, num * sizeof(T));
+    }
+  }
+
+ private:
+  static double fixedScale(const T* values, size_t num) {
+    double max_abs = 0;
+    for (size_t i = 0; i < num; ++i) {
+      max_abs = std::max(max_abs, std::fabs(static_cast<double>(values[i])));
+    }
+    return max_abs / kFixedPointMax;
+  }
+
+  static int16_t toFixedPoint(double v, double scale) {
+    return scale == 0 ? 0 : static_cast<int16_t>(std::lround(v / scale));
+  }
+
+  // rounds to the nearest even.
+  static uint16_t toBFloat16(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(float));
+    bits += 0x7fff + ((bits >> 16) & 1);
+    return static_cast<uint16_t>(bits >> 16);
+  }
+
+  static float fromBFloat16(uint16_t v) {
+    uint32_t bits = static_cast<uint32_t>(v) << 16;
+    float ret;
+    memcpy(&ret, &bits, sizeof(float));
+    return ret;
+  }
+
+  static double roundTrip(LossyCodecType type, double v, double scale) {
+    switch (type) {
+    case LossyCodecType::kFloat:
+      return static_cast<float>(v);
+    case LossyCodecType::kBFloat16:
+      return fromBFloat16(toBFloat16(static_cast<float>(v)));
+    case LossyCodecType::kFixedPoint:
+      return toFixedPoint(v, scale) * scale;
+    default:
+      return v;
+    }
+  }
+};
+
+}  // namespace grape
+
+#endif  // GRAPE_SERIALIZATION_MESSAGE_CODEC_H_
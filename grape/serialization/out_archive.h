@@ -122,7 +122,7 @@ class OutArchive {
 
   inline bool Empty() const { return (begin_ == end_); }
 
-  inline void* GetBytes(unsigned int size) {
+  inline void* GetBytes(size_t size) {
     char* ret = begin_;
     begin_ += size;
     return ret;
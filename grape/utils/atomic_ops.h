@@ -95,6 +95,34 @@ inline bool atomic_min(T& a, T b) {
   return done;
 }
 
+/**
+ * @brief Atomic compare and store the maximum value. Equavalent to:
+ *
+ * \code
+ * if (a < b) {
+ *   a = b;
+ *   return true;
+ * } else {
+ *   return false;
+ * }
+ * \endcode
+ *
+ * @tparam T Type of the operands.
+ * @param a Object to process.
+ * @param b Value to compare.
+ *
+ * @return Whether the value has been changed.
+ */
+template <typename T>
+inline bool atomic_max(T& a, T b) {
+  volatile T curr_a;
+  bool done = false;
+  do {
+    curr_a = a;
+  } while (curr_a < b && !(done = atomic_compare_and_swap(a, curr_a, b)));
+  return done;
+}
+
 /**
  * @brief Atomic add a value. Equavalent to:
  *
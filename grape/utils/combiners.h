@@ -0,0 +1,64 @@
+/** Copyright 2020 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file combiners.h
+ *
+ * Functors to combine two values into one, e.g., partial results of a vertex
+ * computed by different threads.
+ */
+
+#ifndef GRAPE_UTILS_COMBINERS_H_
+#define GRAPE_UTILS_COMBINERS_H_
+
+namespace grape {
+
+/**
+ * @brief Combine by sum, equivalent to lhs += rhs.
+ */
+struct SumCombiner {
+  template <typename T>
+  inline void operator()(T& lhs, const T& rhs) const {
+    lhs += rhs;
+  }
+};
+
+/**
+ * @brief Combine by minimum, equivalent to lhs = min(lhs, rhs).
+ */
+struct MinCombiner {
+  template <typename T>
+  inline void operator()(T& lhs, const T& rhs) const {
+    if (rhs < lhs) {
+      lhs = rhs;
+    }
+  }
+};
+
+/**
+ * @brief Combine by maximum, equivalent to lhs = max(lhs, rhs).
+ */
+struct MaxCombiner {
+  template <typename T>
+  inline void operator()(T& lhs, const T& rhs) const {
+    if (lhs < rhs) {
+      lhs = rhs;
+    }
+  }
+};
+
+}  // namespace grape
+
+#endif  // GRAPE_UTILS_COMBINERS_H_
@@ -17,11 +17,15 @@ limitations under the License.
 #define GRAPE_UTILS_CONCURRENT_QUEUE_H_
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <deque>
 #include <limits>
 #include <mutex>
+#include <thread>
 #include <utility>
+#include <vector>
 
 namespace grape {
 
@@ -234,6 +238,298 @@ class NonblockingQueue {
   SpinLock lock_;
 };
 
+/**
+ * @brief A lock-free concurrent queue based on a bounded ring buffer, which
+ * can be accessed by multi-producers and multi-consumers simultaneously.
+ *
+ * Slots of the ring are claimed with CAS on the enqueue/dequeue positions,
+ * and each slot carries a sequence number telling whether it is ready to be
+ * written or read. Entities put into a full ring spill over to a deque
+ * guarded by a spinlock rather than blocking the producer, since producers
+ * like the recv thread of a message manager must never be blocked by
+ * consumers. The order of entities is not preserved in that case.
+ *
+ * The termination semantics are the same as BlockingQueue: Get waits while
+ * the queue is empty and there are alive producers, and returns false once
+ * the queue is empty and all the producers called DecProducerNum.
+ *
+ * @tparam T Type of entities in the queue.
+ */
+template <typename T>
+class LockFreeQueue {
+  static constexpr size_t kDefaultCapacity = 1024;
+  static constexpr int kSpinCount = 1024;
+  static constexpr int kCacheLineSize = 64;
+
+  struct Cell {
+    std::atomic<size_t> seq;
+    T data;
+  };
+
+ public:
+  /**
+   * @param capacity Capacity of the ring, rounded up to a power of 2.
+   */
+  explicit LockFreeQueue(size_t capacity = kDefaultCapacity)
+      : mask_(roundUp(capacity) - 1),
+        cells_(mask_ + 1),
+        enqueue_pos_(0),
+        dequeue_pos_(0),
+        spill_size_(0),
+        producer_num_(0) {
+    for (size_t i = 0; i <= mask_; ++i) {
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+  ~LockFreeQueue() {}
+
+  LockFreeQueue(const LockFreeQueue&) = delete;
+  LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+  /**
+   * @brief When a producer finished producing, it will call this function.
+   * Entities put by the producer before are visible to consumers once they
+   * observe the decrement.
+   */
+  void DecProducerNum() {
+    producer_num_.fetch_sub(1, std::memory_order_acq_rel);
+  }
+
+  /**
+   * @brief Set the number of producers to this queue.
+   *
+   * This function is supposed to be called before producers start to put
+   * entities into this queue.
+   *
+   * @param pn Number of producers to this queue.
+   */
+  void SetProducerNum(int pn) {
+    producer_num_.store(pn, std::memory_order_release);
+  }
+
+  /**
+   * @brief Put an entity into this queue, it never blocks.
+   *
+   * @param item The entity to be put.
+   */
+  void Put(const T& item) {
+    T copy(item);
+    Put(std::move(copy));
+  }
+
+  /**
+   * @brief Put an entity into this queue, it never blocks.
+   *
+   * @param item The entity to be put.
+   */
+  void Put(T&& item) {
+    if (tryPut(item)) {
+      return;
+    }
+    spill_lock_.lock();
+    spill_.emplace_back(std::move(item));
+    spill_size_.fetch_add(1, std::memory_order_release);
+    spill_lock_.unlock();
+  }
+
+  /**
+   * @brief Get an entity from this queue.
+   *
+   * This function spins, then sleeps, when there are alive producers and the
+   * queue is empty.
+   *
+   * @param item Reference of an entity to hold the got data.
+   *
+   * @return If got data, return true. Otherwise, return false.
+   */
+  bool Get(T& item) {
+    int spin = 0;
+    while (true) {
+      if (tryGet(item)) {
+        return true;
+      }
+      if (producer_num_.load(std::memory_order_acquire) == 0) {
+        // entities put before the last DecProducerNum are visible now.
+        return tryGet(item);
+      }
+      if (spin < kSpinCount) {
+        ++spin;
+        std::this_thread::yield();
+      } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+      }
+    }
+  }
+
+  size_t Size() const {
+    return enqueue_pos_.load(std::memory_order_relaxed) -
+           dequeue_pos_.load(std::memory_order_relaxed) +
+           spill_size_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  static size_t roundUp(size_t capacity) {
+    size_t ret = 2;
+    while (ret < capacity) {
+      ret <<= 1;
+    }
+    return ret;
+  }
+
+  bool tryPut(T& item) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = cells_[pos & mask_];
+      size_t seq = cell.seq.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          cell.data = std::move(item);
+          cell.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        // the ring is full.
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool tryGet(T& item) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = cells_[pos & mask_];
+      size_t seq = cell.seq.load(std::memory_order_acquire);
+      intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          item = std::move(cell.data);
+          cell.seq.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        // the ring is empty.
+        break;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    if (spill_size_.load(std::memory_order_acquire) == 0) {
+      return false;
+    }
+    bool ret = false;
+    spill_lock_.lock();
+    if (!spill_.empty()) {
+      item = std::move(spill_.front());
+      spill_.pop_front();
+      spill_size_.fetch_sub(1, std::memory_order_relaxed);
+      ret = true;
+    }
+    spill_lock_.unlock();
+    return ret;
+  }
+
+  const size_t mask_;
+  std::vector<Cell> cells_;
+
+  // Avoid false sharing between producers and consumers.
+  char padding0_[kCacheLineSize];
+  std::atomic<size_t> enqueue_pos_;
+  char padding1_[kCacheLineSize - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> dequeue_pos_;
+  char padding2_[kCacheLineSize - sizeof(std::atomic<size_t>)];
+
+  std::deque<T> spill_;
+  std::atomic<size_t> spill_size_;
+  SpinLock spill_lock_;
+
+  std::atomic<int> producer_num_;
+};
+
+/**
+ * @brief A range of indices [begin, end) which can be consumed from both ends
+ * simultaneously, i.e., a deque of tasks which can be stolen.
+ *
+ * The owner thread pops from the front, while other threads steal from the
+ * back, so the owner keeps working on consecutive indices. Both ends are
+ * packed in a single 64-bit word and updated with CAS.
+ */
+class StealableRange {
+  static constexpr int kCacheLineSize = 64;
+
+ public:
+  StealableRange() : range_(0) {}
+  ~StealableRange() {}
+
+  /**
+   * @brief Reset the range to [begin, end), not thread safe.
+   */
+  void Init(uint32_t begin, uint32_t end) {
+    range_.store(pack(begin, end), std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Take the first index, called by the owner.
+   *
+   * @param index Reference to hold the taken index.
+   *
+   * @return If got an index, return true. Otherwise, return false.
+   */
+  bool PopFront(uint32_t& index) {
+    uint64_t old_range = range_.load(std::memory_order_relaxed);
+    while (true) {
+      uint32_t begin = old_range >> 32, end = old_range & 0xffffffff;
+      if (begin >= end) {
+        return false;
+      }
+      if (range_.compare_exchange_weak(old_range, pack(begin + 1, end),
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_relaxed)) {
+        index = begin;
+        return true;
+      }
+    }
+  }
+
+  /**
+   * @brief Take the last index, called by thieves.
+   *
+   * @param index Reference to hold the taken index.
+   *
+   * @return If got an index, return true. Otherwise, return false.
+   */
+  bool PopBack(uint32_t& index) {
+    uint64_t old_range = range_.load(std::memory_order_relaxed);
+    while (true) {
+      uint32_t begin = old_range >> 32, end = old_range & 0xffffffff;
+      if (begin >= end) {
+        return false;
+      }
+      if (range_.compare_exchange_weak(old_range, pack(begin, end - 1),
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_relaxed)) {
+        index = end - 1;
+        return true;
+      }
+    }
+  }
+
+ private:
+  static uint64_t pack(uint32_t begin, uint32_t end) {
+    return (static_cast<uint64_t>(begin) << 32) | end;
+  }
+
+  std::atomic<uint64_t> range_;
+  // Avoid false sharing between the ranges of different threads.
+  char padding_[kCacheLineSize - sizeof(std::atomic<uint64_t>)];
+};
+
 }  // namespace grape
 
 #endif  // GRAPE_UTILS_CONCURRENT_QUEUE_H_
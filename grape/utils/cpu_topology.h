@@ -0,0 +1,247 @@
+/** Copyright 2020 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef GRAPE_UTILS_CPU_TOPOLOGY_H_
+#define GRAPE_UTILS_CPU_TOPOLOGY_H_
+
+#ifdef __linux__
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace grape {
+
+/**
+ * @brief Layout of cpus on NUMA nodes and physical cores, read from
+ * /sys/devices/system/node and /sys/devices/system/cpu.
+ *
+ * Nodes without cpus are ignored, and nodes are renumbered consecutively from
+ * 0. Cores are ordered by node, each of them holds its hyperthreads. If the
+ * topology is not available, e.g., on non-Linux systems, all the cpus are
+ * regarded as on a single node, and each cpu as a core.
+ */
+class CpuTopology {
+ public:
+  CpuTopology() { load(); }
+  ~CpuTopology() {}
+
+  /**
+   * @brief Number of NUMA nodes with cpus.
+   */
+  size_t node_num() const { return node_cpus_.size(); }
+
+  /**
+   * @brief Cpus on the given node, in ascending order.
+   */
+  const std::vector<uint32_t>& node_cpus(size_t node) const {
+    return node_cpus_[node];
+  }
+
+  /**
+   * @brief Node of the given cpu, 0 if the cpu is unknown.
+   */
+  uint32_t cpu_node(uint32_t cpu) const {
+    return cpu < cpu_node_.size() ? cpu_node_[cpu] : 0;
+  }
+
+  /**
+   * @brief Number of physical cores.
+   */
+  size_t core_num() const { return cores_.size(); }
+
+  /**
+   * @brief Hyperthreads of the given core, in ascending order.
+   */
+  const std::vector<uint32_t>& core_cpus(size_t core) const {
+    return cores_[core];
+  }
+
+  /**
+   * @brief Cpus of cores [core_begin, core_end), in the order to bind
+   * threads.
+   *
+   * The first hyperthreads of all the cores come before the second ones, so
+   * that threads bound in this order don't share a physical core unless
+   * there are more threads than cores. Among hyperthreads of the same rank,
+   * cores are taken from nodes round-robin, so that threads are spread over
+   * nodes evenly.
+   */
+  std::vector<uint32_t> CoreSpreadCpus(size_t core_begin,
+                                       size_t core_end) const {
+    std::vector<std::vector<size_t>> node_cores(node_num());
+    size_t max_smt = 0;
+    for (size_t core = core_begin; core < core_end; ++core) {
+      node_cores[cpu_node(cores_[core][0])].push_back(core);
+      max_smt = std::max(max_smt, cores_[core].size());
+    }
+    std::vector<uint32_t> cpus;
+    for (size_t smt = 0; smt < max_smt; ++smt) {
+      for (size_t k = 0;; ++k) {
+        bool found = false;
+        for (auto& vec : node_cores) {
+          if (k < vec.size()) {
+            found = true;
+            auto& core = cores_[vec[k]];
+            if (smt < core.size()) {
+              cpus.push_back(core[smt]);
+            }
+          }
+        }
+        if (!found) {
+          break;
+        }
+      }
+    }
+    return cpus;
+  }
+
+ private:
+  void load() {
+    static const std::string kNodeDir = "/sys/devices/system/node/";
+    std::vector<uint32_t> nodes;
+    std::string line;
+    if (readLine(kNodeDir + "online", line) && parseCpuList(line, nodes)) {
+      for (auto node : nodes) {
+        std::vector<uint32_t> cpus;
+        if (readLine(kNodeDir + "node" + std::to_string(node) + "/cpulist",
+                     line) &&
+            parseCpuList(line, cpus) && !cpus.empty()) {
+          node_cpus_.emplace_back(std::move(cpus));
+        }
+      }
+    }
+    if (node_cpus_.empty()) {
+      std::vector<uint32_t> cpus(
+          std::max(std::thread::hardware_concurrency(), 1u));
+      for (uint32_t i = 0; i < cpus.size(); ++i) {
+        cpus[i] = i;
+      }
+      node_cpus_.emplace_back(std::move(cpus));
+    }
+
+    uint32_t max_cpu = 0;
+    for (auto& vec : node_cpus_) {
+      max_cpu = std::max(max_cpu, vec.back());
+    }
+    cpu_node_.resize(max_cpu + 1, 0);
+    for (uint32_t node = 0; node < node_cpus_.size(); ++node) {
+      for (auto cpu : node_cpus_[node]) {
+        cpu_node_[cpu] = node;
+      }
+    }
+
+    // a core is led by its first hyperthread.
+    static const std::string kCpuDir = "/sys/devices/system/cpu/";
+    for (uint32_t node = 0; node < node_cpus_.size(); ++node) {
+      for (auto cpu : node_cpus_[node]) {
+        std::vector<uint32_t> siblings, core;
+        if (!readLine(kCpuDir + "cpu" + std::to_string(cpu) +
+                          "/topology/thread_siblings_list",
+                      line) ||
+            !parseCpuList(line, siblings)) {
+          siblings.assign(1, cpu);
+        }
+        for (auto sibling : siblings) {
+          if (std::binary_search(node_cpus_[node].begin(),
+                                 node_cpus_[node].end(), sibling)) {
+            core.push_back(sibling);
+          }
+        }
+        if (core.empty()) {
+          core.push_back(cpu);
+        }
+        if (core[0] == cpu) {
+          cores_.emplace_back(std::move(core));
+        }
+      }
+    }
+  }
+
+  static bool readLine(const std::string& path, std::string& line) {
+    std::ifstream fin(path.c_str());
+    return static_cast<bool>(std::getline(fin, line));
+  }
+
+  // Parse lists like "0-3,8-11,16".
+  static bool parseCpuList(const std::string& str, std::vector<uint32_t>& ids) {
+    std::stringstream ss(str);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+      if (item.empty() || item == "\n") {
+        continue;
+      }
+      uint32_t first, last;
+      char dash;
+      std::stringstream iss(item);
+      if (!(iss >> first)) {
+        return false;
+      }
+      if (iss >> dash) {
+        if (dash != '-' || !(iss >> last)) {
+          return false;
+        }
+      } else {
+        last = first;
+      }
+      for (uint32_t id = first; id <= last; ++id) {
+        ids.push_back(id);
+      }
+    }
+    std::sort(ids.begin(), ids.end());
+    return !ids.empty();
+  }
+
+  std::vector<std::vector<uint32_t>> node_cpus_;
+  std::vector<uint32_t> cpu_node_;
+  std::vector<std::vector<uint32_t>> cores_;
+};
+
+/**
+ * @brief Bind a thread to a set of cpus. It does nothing if cpus is empty, or
+ * on systems not supporting thread affinity.
+ *
+ * @param thrd The thread to be bound.
+ * @param cpus Cpus the thread is allowed to run on.
+ */
+inline void BindThreadToCpus(std::thread& thrd,
+                             const std::vector<uint32_t>& cpus) {
+#ifdef __linux__
+  if (cpus.empty()) {
+    return;
+  }
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  for (auto cpu : cpus) {
+    CPU_SET(cpu, &cpuset);
+  }
+  pthread_setaffinity_np(thrd.native_handle(), sizeof(cpu_set_t), &cpuset);
+#endif
+}
+
+}  // namespace grape
+
+#endif  // GRAPE_UTILS_CPU_TOPOLOGY_H_
@@ -332,6 +332,24 @@ class Array {
     }
   }
 
+  /**
+   * @brief Reallocate memory for __n elements without constructing them, the
+   * previous elements are dropped. It is available only for trivial types,
+   * and the elements must be assigned before being read.
+   *
+   * Pages of the memory are not touched, so that they can be placed on the
+   * NUMA nodes of the threads first writing them.
+   */
+  void reset_uninitialized(size_type __n) {
+    static_assert(std::is_trivial<_Tp>::value,
+                  "Only trivial types can be left uninitialized.");
+    clear();
+    if (__n > 0) {
+      __vallocate(__n);
+      this->__base.__end_ = this->__base.__begin_ + __n;
+    }
+  }
+
   bool empty() const noexcept { return this->__base.empty(); }
 
   reference operator[](size_type __n) noexcept {
@@ -472,6 +490,8 @@ class Array<EmptyType, _Alloc> {
     this->__size = __new_size;
   }
 
+  void reset_uninitialized(size_type __n) { this->__size = __n; }
+
   bool empty() const noexcept { return this->__size == 0; }
 
   reference operator[](size_type) noexcept { return this->__val; }
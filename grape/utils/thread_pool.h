@@ -0,0 +1,198 @@
+/** Copyright 2020 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef GRAPE_UTILS_THREAD_POOL_H_
+#define GRAPE_UTILS_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "grape/utils/cpu_topology.h"
+
+namespace grape {
+
+/**
+ * @brief A pool of persistent worker threads.
+ *
+ * Workers are created once in Start and parked between tasks. RunTask
+ * publishes a task to all the workers, each of them invokes the task with its
+ * own thread id, and the caller is blocked until all the workers finished.
+ *
+ * Both the dispatch and the completion use a barrier which spins for a short
+ * while before falling back to condition variables, so back-to-back tasks
+ * are dispatched with low latency, while idle workers don't burn cpu.
+ *
+ * Only one task can be in flight, RunTask must not be called from inside a
+ * task, nor from another thread while a task is running.
+ */
+class ThreadPool {
+  static constexpr int kSpinCount = 4096;
+
+ public:
+  ThreadPool()
+      : thread_num_(0),
+        round_(0),
+        remaining_(0),
+        running_(false),
+        stop_(false),
+        task_(NULL),
+        invoker_(NULL) {}
+
+  ~ThreadPool() { Stop(); }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * @brief Create the worker threads, the previous workers will be stopped
+   * if the pool has been started.
+   *
+   * @param thread_num Number of worker threads.
+   * @param cpu_list If not empty, the i-th worker will be bound to
+   * cpu_list[i].
+   */
+  void Start(uint32_t thread_num,
+             const std::vector<uint32_t>& cpu_list = std::vector<uint32_t>()) {
+    Stop();
+    stop_ = false;
+    thread_num_ = thread_num;
+    threads_.resize(thread_num_);
+    uint64_t round = round_.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < thread_num_; ++i) {
+      threads_[i] = std::thread(&ThreadPool::workerRoutine, this, i, round);
+      if (i < cpu_list.size()) {
+        BindThreadToCpus(threads_[i], {cpu_list[i]});
+      }
+    }
+  }
+
+  /**
+   * @brief Stop and join all the worker threads.
+   */
+  void Stop() {
+    if (threads_.empty()) {
+      return;
+    }
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      stop_ = true;
+      round_.fetch_add(1, std::memory_order_release);
+    }
+    start_cv_.notify_all();
+    for (auto& thrd : threads_) {
+      thrd.join();
+    }
+    threads_.clear();
+    thread_num_ = 0;
+  }
+
+  /**
+   * @brief Invoke func(tid) on each worker thread, and wait until all of them
+   * returned. Nested or concurrent calls are rejected.
+   *
+   * @tparam FUNC_T Type of the task, callable with a uint32_t thread id.
+   * @param func The task.
+   */
+  template <typename FUNC_T>
+  void RunTask(const FUNC_T& func) {
+    CHECK(!running_.exchange(true, std::memory_order_acquire))
+        << "RunTask is not reentrant, a task is already running on the pool.";
+    task_ = &func;
+    invoker_ = &ThreadPool::invoke<FUNC_T>;
+    remaining_.store(thread_num_, std::memory_order_relaxed);
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      round_.fetch_add(1, std::memory_order_release);
+    }
+    start_cv_.notify_all();
+
+    for (int spin = 0; spin < kSpinCount; ++spin) {
+      if (remaining_.load(std::memory_order_acquire) == 0) {
+        running_.store(false, std::memory_order_release);
+        return;
+      }
+      std::this_thread::yield();
+    }
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      while (remaining_.load(std::memory_order_acquire) != 0) {
+        done_cv_.wait(lk);
+      }
+    }
+    running_.store(false, std::memory_order_release);
+  }
+
+  uint32_t thread_num() const { return thread_num_; }
+
+  bool Started() const { return !threads_.empty(); }
+
+ private:
+  template <typename FUNC_T>
+  static void invoke(const void* task, uint32_t tid) {
+    (*static_cast<const FUNC_T*>(task))(tid);
+  }
+
+  void workerRoutine(uint32_t tid, uint64_t seen) {
+    while (true) {
+      int spin = 0;
+      while (round_.load(std::memory_order_acquire) == seen) {
+        if (spin < kSpinCount) {
+          ++spin;
+          std::this_thread::yield();
+        } else {
+          std::unique_lock<std::mutex> lk(mutex_);
+          while (round_.load(std::memory_order_acquire) == seen) {
+            start_cv_.wait(lk);
+          }
+        }
+      }
+      seen = round_.load(std::memory_order_acquire);
+      if (stop_) {
+        break;
+      }
+
+      invoker_(task_, tid);
+
+      if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::unique_lock<std::mutex> lk(mutex_);
+        done_cv_.notify_one();
+      }
+    }
+  }
+
+  uint32_t thread_num_;
+  std::vector<std::thread> threads_;
+
+  std::atomic<uint64_t> round_;
+  std::atomic<uint32_t> remaining_;
+  // whether a task is in flight, to reject nested or concurrent RunTask.
+  std::atomic<bool> running_;
+  bool stop_;
+
+  const void* task_;
+  void (*invoker_)(const void*, uint32_t);
+
+  std::mutex mutex_;
+  std::condition_variable start_cv_, done_cv_;
+};
+
+}  // namespace grape
+
+#endif  // GRAPE_UTILS_THREAD_POOL_H_
@@ -185,6 +185,16 @@ class VertexArray : public Array<T, Allocator<T>> {
     fake_start_ = Base::data() - range_.begin().GetValue();
   }
 
+  /**
+   * @brief Init without constructing the elements, see
+   * Array::reset_uninitialized.
+   */
+  void InitUninitialized(const VertexRange<VID_T>& range) {
+    Base::reset_uninitialized(range.size());
+    range_ = range;
+    fake_start_ = Base::data() - range_.begin().GetValue();
+  }
+
   void SetValue(VertexRange<VID_T>& range, const T& value) {
     std::fill_n(
         &Base::data()[range.begin().GetValue() - range_.begin().GetValue()],
@@ -16,7 +16,10 @@ limitations under the License.
 #ifndef GRAPE_UTILS_VERTEX_SET_H_
 #define GRAPE_UTILS_VERTEX_SET_H_
 
+#include <algorithm>
+#include <atomic>
 #include <utility>
+#include <vector>
 
 #include "grape/utils/bitset.h"
 #include "grape/utils/vertex_array.h"
@@ -106,6 +109,216 @@ class DenseVertexSet {
   Bitset bs_;
 };
 
+/**
+ * @brief A vertex set for frontiers of traversal algorithms, which switches
+ * between a sparse and a dense representation by its size.
+ *
+ * A Frontier starts sparse after being cleared, inserted vertices are
+ * appended to lists local to the inserting threads, so iterating and
+ * clearing a small frontier costs O(active vertices) instead of O(range).
+ * Once the lists grow beyond range size / kSparseRatio, the frontier turns
+ * dense and is iterated through the bitmap.
+ *
+ * The bitmap is maintained in both modes to deduplicate insertions and
+ * answer Exist queries.
+ *
+ * @tparam VID_T Vertex ID type.
+ */
+template <typename VID_T>
+class Frontier {
+  static constexpr size_t kSparseRatio = 64;
+  static constexpr int kCacheLineSize = 64;
+
+  struct LocalList {
+    std::vector<Vertex<VID_T>> vertices;
+    // Avoid false sharing between the lists of different threads.
+    char padding_[kCacheLineSize - sizeof(std::vector<Vertex<VID_T>>)];
+  };
+
+ public:
+  Frontier() : sparse_limit_(0), dense_(false) {}
+
+  ~Frontier() {}
+
+  Frontier(const Frontier&) = delete;
+  Frontier& operator=(const Frontier&) = delete;
+
+  /**
+   * @brief Initialize an empty frontier.
+   *
+   * @param range Range of vertices the frontier may contain.
+   * @param thread_num Number of threads inserting concurrently, the tid
+   * passed to Insert must be less than it.
+   */
+  void Init(const VertexRange<VID_T>& range, int thread_num = 1) {
+    set_.Init(range, thread_num);
+    lists_.clear();
+    lists_.resize(thread_num);
+    sparse_limit_ = std::max(range.size() / kSparseRatio / thread_num,
+                             static_cast<size_t>(1));
+    dense_.store(false, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Insert a vertex, it is thread safe as long as concurrent callers
+   * have different tids.
+   *
+   * @return true if u was not in the frontier.
+   */
+  bool Insert(Vertex<VID_T> u, int tid = 0) {
+    if (!set_.InsertWithRet(u)) {
+      return false;
+    }
+    if (!dense_.load(std::memory_order_relaxed)) {
+      auto& vertices = lists_[tid].vertices;
+      vertices.push_back(u);
+      if (vertices.size() > sparse_limit_) {
+        dense_.store(true, std::memory_order_relaxed);
+      }
+    }
+    return true;
+  }
+
+  bool Exist(Vertex<VID_T> u) const { return set_.Exist(u); }
+
+  VertexRange<VID_T> Range() const { return set_.Range(); }
+
+  bool IsDense() const { return dense_.load(std::memory_order_relaxed); }
+
+  size_t Count() const {
+    if (IsDense()) {
+      return set_.Count();
+    }
+    size_t ret = 0;
+    for (auto& list : lists_) {
+      ret += list.vertices.size();
+    }
+    return ret;
+  }
+
+  size_t ParallelCount(int thread_num) const {
+    if (IsDense()) {
+      return set_.ParallelCount(thread_num);
+    }
+    return Count();
+  }
+
+  size_t PartialCount(VID_T beg, VID_T end) const {
+    if (IsDense()) {
+      return set_.PartialCount(beg, end);
+    }
+    size_t ret = 0;
+    for (auto& list : lists_) {
+      for (auto v : list.vertices) {
+        ret += (v.GetValue() >= beg && v.GetValue() < end);
+      }
+    }
+    return ret;
+  }
+
+  size_t ParallelPartialCount(int thread_num, VID_T beg, VID_T end) const {
+    if (IsDense()) {
+      return set_.ParallelPartialCount(thread_num, beg, end);
+    }
+    return PartialCount(beg, end);
+  }
+
+  bool Empty() const {
+    if (IsDense()) {
+      return set_.Empty();
+    }
+    for (auto& list : lists_) {
+      if (!list.vertices.empty()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool PartialEmpty(VID_T beg, VID_T end) const {
+    if (IsDense()) {
+      return set_.PartialEmpty(beg, end);
+    }
+    for (auto& list : lists_) {
+      for (auto v : list.vertices) {
+        if (v.GetValue() >= beg && v.GetValue() < end) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Remove all the vertices, a sparse frontier only resets the bits
+   * of its vertices. The frontier is sparse afterwards.
+   */
+  void Clear() {
+    if (IsDense()) {
+      set_.Clear();
+    } else {
+      for (auto& list : lists_) {
+        for (auto v : list.vertices) {
+          set_.Erase(v);
+        }
+      }
+    }
+    resetLists();
+  }
+
+  void ParallelClear(int thread_num) {
+    if (IsDense()) {
+      set_.ParallelClear(thread_num);
+    } else {
+      int list_num = lists_.size();
+#pragma omp parallel for num_threads(thread_num)
+      for (int i = 0; i < list_num; ++i) {
+        for (auto v : lists_[i].vertices) {
+          set_.Erase(v);
+        }
+      }
+    }
+    resetLists();
+  }
+
+  void Swap(Frontier<VID_T>& rhs) {
+    set_.Swap(rhs.set_);
+    lists_.swap(rhs.lists_);
+    std::swap(sparse_limit_, rhs.sparse_limit_);
+    bool dense = IsDense();
+    dense_.store(rhs.IsDense(), std::memory_order_relaxed);
+    rhs.dense_.store(dense, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Number of thread local lists, i.e., the thread_num in Init.
+   */
+  int ListNum() const { return lists_.size(); }
+
+  /**
+   * @brief Vertices inserted by thread tid, meaningful only if the frontier
+   * is sparse.
+   */
+  const std::vector<Vertex<VID_T>>& LocalVertices(int tid) const {
+    return lists_[tid].vertices;
+  }
+
+  const DenseVertexSet<VID_T>& GetDenseSet() const { return set_; }
+
+ private:
+  void resetLists() {
+    for (auto& list : lists_) {
+      list.vertices.clear();
+    }
+    dense_.store(false, std::memory_order_relaxed);
+  }
+
+  DenseVertexSet<VID_T> set_;
+  std::vector<LocalList> lists_;
+  size_t sparse_limit_;
+  std::atomic<bool> dense_;
+};
+
 }  // namespace grape
 
 #endif  // GRAPE_UTILS_VERTEX_SET_H_
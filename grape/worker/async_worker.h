@@ -0,0 +1,141 @@
+/** Copyright 2020 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef GRAPE_WORKER_ASYNC_WORKER_H_
+#define GRAPE_WORKER_ASYNC_WORKER_H_
+
+#include <mpi.h>
+
+#include <memory>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+
+#include "grape/communication/communicator.h"
+#include "grape/config.h"
+#include "grape/parallel/async_message_manager.h"
+#include "grape/parallel/parallel_engine.h"
+#include "grape/worker/comm_spec.h"
+
+namespace grape {
+
+template <typename FRAG_T, typename CONTEXT_T>
+class ParallelAppBase;
+
+/**
+ * @brief AsyncWorker runs apps derived from ParallelAppBase asynchronously,
+ * with an AsyncMessageManager. Each worker evaluates IncEval whenever it has
+ * received messages or has local work to continue, without global barriers
+ * between rounds.
+ *
+ * It works with apps whose results are independent of the rounds in which
+ * messages are processed, e.g., SSSP and WCC.
+ *
+ * @tparam APP_T
+ */
+template <typename APP_T>
+class AsyncWorker {
+  static_assert(std::is_base_of<ParallelAppBase<typename APP_T::fragment_t,
+                                                typename APP_T::context_t>,
+                                APP_T>::value,
+                "AsyncWorker should work with ParallelApp");
+
+ public:
+  using fragment_t = typename APP_T::fragment_t;
+  using context_t = typename APP_T::context_t;
+
+  using message_manager_t = AsyncMessageManager;
+
+  static_assert(check_app_fragment_consistency<APP_T, fragment_t>(),
+                "The loaded graph is not valid for application");
+
+  AsyncWorker(std::shared_ptr<APP_T> app, std::shared_ptr<fragment_t> graph)
+      : app_(app), graph_(graph) {}
+
+  virtual ~AsyncWorker() {}
+
+  void Init(const CommSpec& comm_spec,
+            const ParallelEngineSpec& pe_spec = DefaultParallelEngineSpec()) {
+    // prepare for the query
+    graph_->PrepareToRunApp(APP_T::message_strategy, APP_T::need_split_edges);
+
+    comm_spec_ = comm_spec;
+
+    messages_.Init(comm_spec_.comm());
+    messages_.SetCommCpuList(pe_spec.comm_cpu_list);
+
+    InitParallelEngine(app_, pe_spec);
+    InitCommunicator(app_, comm_spec_.comm());
+  }
+
+  /**
+   * @brief Set the staleness bound of fragments, 0 for unbounded.
+   *
+   * @param staleness A fragment starts its round t only after other active
+   * fragments reached round t - staleness + 1.
+   */
+  void SetStaleness(int staleness) { messages_.SetStaleness(staleness); }
+
+  void Finalize() {}
+
+  template <class... Args>
+  void Query(Args&&... args) {
+    MPI_Barrier(comm_spec_.comm());
+
+    context_ = std::make_shared<context_t>();
+    context_->Init(*graph_, messages_, std::forward<Args>(args)...);
+    if (comm_spec_.worker_id() == kCoordinatorRank) {
+      VLOG(1) << "[Coordinator]: Finished Init";
+    }
+
+    messages_.Start();
+
+    messages_.StartARound();
+
+    app_->PEval(*graph_, *context_, messages_);
+
+    messages_.FinishARound();
+
+    if (comm_spec_.worker_id() == kCoordinatorRank) {
+      VLOG(1) << "[Coordinator]: Finished PEval";
+    }
+
+    while (!messages_.ToTerminate()) {
+      messages_.StartARound();
+
+      app_->IncEval(*graph_, *context_, messages_);
+
+      messages_.FinishARound();
+    }
+    VLOG(1) << "[Worker " << comm_spec_.worker_id()
+            << "]: Finished at step " << messages_.Steps();
+    MPI_Barrier(comm_spec_.comm());
+    messages_.Finalize();
+  }
+
+  void Output(std::ostream& os) { context_->Output(*graph_, os); }
+
+ private:
+  std::shared_ptr<APP_T> app_;
+  std::shared_ptr<fragment_t> graph_;
+  std::shared_ptr<context_t> context_;
+  message_manager_t messages_;
+
+  CommSpec comm_spec_;
+};
+
+}  // namespace grape
+
+#endif  // GRAPE_WORKER_ASYNC_WORKER_H_
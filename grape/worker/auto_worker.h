@@ -70,11 +70,24 @@ class AutoWorker {
     MPI_Barrier(comm_spec_.comm());
 
     messages_.Init(comm_spec_.comm());
+    messages_.SetParallelEngineSpec(pe_spec);
 
     InitParallelEngine(app_, pe_spec);
     InitCommunicator(app_, comm_spec_.comm());
   }
 
+  /**
+   * @brief Exchange messages with co-located workers through shared memory,
+   * which is collective and expected after Init.
+   */
+  void EnableShmTransport() { messages_.EnableShmTransport(); }
+
+  /**
+   * @brief Route messages to other hosts through the host leaders, see
+   * DefaultMessageManager::EnableHierarchicalRouting.
+   */
+  void EnableHierarchicalRouting() { messages_.EnableHierarchicalRouting(); }
+
   void Finalize() {}
 
   template <class... Args>
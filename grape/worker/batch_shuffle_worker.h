@@ -76,6 +76,22 @@ class BatchShuffleWorker {
     InitCommunicator(app_, comm_spec_.comm());
   }
 
+  /**
+   * @brief Set the lossy codec of synchronizing mirrors.
+   *
+   * @param codec
+   * @param max_error Bound of the absolute error, 0 for unbounded.
+   */
+  void SetLossyCodec(LossyCodecType codec, double max_error) {
+    messages_.SetLossyCodec(codec, max_error);
+  }
+
+  /**
+   * @brief Exchange messages with co-located workers through shared memory,
+   * which is collective and expected after Init.
+   */
+  void EnableShmTransport() { messages_.EnableShmTransport(); }
+
   void Finalize() {}
 
   template <class... Args>
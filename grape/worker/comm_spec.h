@@ -38,6 +38,8 @@ class CommSpec {
         worker_id_(0),
         local_num_(1),
         local_id_(0),
+        host_num_(1),
+        host_id_(0),
         fid_(0),
         fnum_(1),
         comm_(NULL_COMM),
@@ -48,6 +50,10 @@ class CommSpec {
         worker_id_(comm_spec.worker_id_),
         local_num_(comm_spec.local_num_),
         local_id_(comm_spec.local_id_),
+        host_num_(comm_spec.host_num_),
+        host_id_(comm_spec.host_id_),
+        worker_hosts_(comm_spec.worker_hosts_),
+        host_leaders_(comm_spec.host_leaders_),
         fid_(comm_spec.fid_),
         fnum_(comm_spec.fnum_),
         comm_(comm_spec.comm_),
@@ -68,6 +74,10 @@ class CommSpec {
     worker_id_ = rhs.worker_id_;
     local_num_ = rhs.local_num_;
     local_id_ = rhs.local_id_;
+    host_num_ = rhs.host_num_;
+    host_id_ = rhs.host_id_;
+    worker_hosts_ = rhs.worker_hosts_;
+    host_leaders_ = rhs.host_leaders_;
     fid_ = rhs.fid_;
     fnum_ = rhs.fnum_;
     comm_ = rhs.comm_;
@@ -107,6 +117,21 @@ class CommSpec {
 
   inline int local_id() const { return local_id_; }
 
+  /**
+   * @brief Number of hosts, which are numbered in the order of their first
+   * workers.
+   */
+  inline int host_num() const { return host_num_; }
+
+  inline int host_id() const { return host_id_; }
+
+  inline int WorkerToHost(int wid) const { return worker_hosts_[wid]; }
+
+  /**
+   * @brief The leader of a host, i.e., its first worker.
+   */
+  inline int HostLeader(int host_id) const { return host_leaders_[host_id]; }
+
   inline fid_t fnum() const { return fnum_; }
 
   inline fid_t fid() const { return fid_; }
@@ -136,6 +161,22 @@ class CommSpec {
         ++local_num_;
       }
     }
+
+    worker_hosts_.resize(worker_num_);
+    host_leaders_.clear();
+    for (int i = 0; i < worker_num_; ++i) {
+      int host = 0;
+      while (host < static_cast<int>(host_leaders_.size()) &&
+             worker_host_names[host_leaders_[host]] != worker_host_names[i]) {
+        ++host;
+      }
+      if (host == static_cast<int>(host_leaders_.size())) {
+        host_leaders_.push_back(i);
+      }
+      worker_hosts_[i] = host;
+    }
+    host_num_ = static_cast<int>(host_leaders_.size());
+    host_id_ = worker_hosts_[worker_id_];
   }
 
   int worker_num_;
@@ -144,6 +185,11 @@ class CommSpec {
   int local_num_;
   int local_id_;
 
+  int host_num_;
+  int host_id_;
+  std::vector<int> worker_hosts_;
+  std::vector<int> host_leaders_;
+
   fid_t fid_;
   fid_t fnum_;
 
@@ -68,11 +68,19 @@ class ParallelWorker {
     comm_spec_ = comm_spec;
 
     messages_.Init(comm_spec_.comm());
+    messages_.SetCommCpuList(pe_spec.comm_cpu_list);
+    messages_.SetSpeculativeTermination(APP_T::speculative_termination);
 
     InitParallelEngine(app_, pe_spec);
     InitCommunicator(app_, comm_spec_.comm());
   }
 
+  /**
+   * @brief Exchange messages with co-located workers through shared memory,
+   * which is collective and expected after Init.
+   */
+  void EnableShmTransport() { messages_.EnableShmTransport(); }
+
   void Finalize() {}
 
   template <class... Args>
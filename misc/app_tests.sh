@@ -75,6 +75,12 @@ for np in ${proc_list}; do
     RunWeightedApp ${np} sssp_auto --sssp_source=6 --deserialize=true --serialization_prefix=./serial/${GRAPH}
     ExactVerify ${GRAPE_HOME}/dataset/${GRAPH}-SSSP
 
+    RunWeightedApp ${np} sssp_async --sssp_source=6 --deserialize=true --serialization_prefix=./serial/${GRAPH}
+    ExactVerify ${GRAPE_HOME}/dataset/${GRAPH}-SSSP
+
+    RunWeightedApp ${np} sssp_async --sssp_source=6 --deserialize=true --serialization_prefix=./serial/${GRAPH} --async_staleness=2
+    ExactVerify ${GRAPE_HOME}/dataset/${GRAPH}-SSSP
+
     RunWeightedApp ${np} sssp --sssp_source=6 --serialize=true --serialization_prefix=./serial/${GRAPH} --directed
     ExactVerify ${GRAPE_HOME}/dataset/${GRAPH}-SSSP-directed
 
@@ -96,6 +102,12 @@ for np in ${proc_list}; do
     RunApp ${np} pagerank --pr_mr=10 --pr_d=0.85
     EpsVerify ${GRAPE_HOME}/dataset/${GRAPH}-PR
 
+    RunApp ${np} pagerank --pr_mr=10 --pr_d=0.85 --sync_codec=float
+    EpsVerify ${GRAPE_HOME}/dataset/${GRAPH}-PR
+
+    RunApp ${np} pagerank --pr_mr=10 --pr_d=0.85 --sync_codec=fixed --sync_max_error=1e-10
+    EpsVerify ${GRAPE_HOME}/dataset/${GRAPH}-PR
+
     RunApp ${np} pagerank_auto --pr_mr=10 --pr_d=0.85
     EpsVerify ${GRAPE_HOME}/dataset/${GRAPH}-PR
 
@@ -111,6 +123,21 @@ for np in ${proc_list}; do
     RunApp ${np} pagerank_auto --pr_mr=10 --pr_d=0.85 --directed
     EpsVerify ${GRAPE_HOME}/dataset/${GRAPH}-PR-directed
 
+    RunApp ${np} pagerank --pr_mr=10 --pr_d=0.85 --shm_transport
+    EpsVerify ${GRAPE_HOME}/dataset/${GRAPH}-PR
+
+    RunApp ${np} pagerank_parallel --pr_mr=10 --pr_d=0.85 --shm_transport
+    EpsVerify ${GRAPE_HOME}/dataset/${GRAPH}-PR
+
+    RunApp ${np} sssp_auto --sssp_source=6 --shm_transport
+    ExactVerify ${GRAPE_HOME}/dataset/${GRAPH}-SSSP
+
+    RunApp ${np} sssp_auto --sssp_source=6 --hierarchical_routing
+    ExactVerify ${GRAPE_HOME}/dataset/${GRAPH}-SSSP
+
+    RunApp ${np} pagerank_auto --pr_mr=10 --pr_d=0.85 --hierarchical_routing --shm_transport
+    EpsVerify ${GRAPE_HOME}/dataset/${GRAPH}-PR
+
     RunApp ${np} cdlp --cdlp_mr=10
     ExactVerify ${GRAPE_HOME}/dataset/${GRAPH}-CDLP
 
@@ -128,6 +155,12 @@ for np in ${proc_list}; do
 
     RunApp ${np} wcc_auto
     WCCVerify ${GRAPE_HOME}/dataset/${GRAPH}-WCC
+
+    RunApp ${np} wcc_async
+    WCCVerify ${GRAPE_HOME}/dataset/${GRAPH}-WCC
+
+    RunApp ${np} wcc_async --async_staleness=2
+    WCCVerify ${GRAPE_HOME}/dataset/${GRAPH}-WCC
 done
 
 popd